@@ -9,6 +9,6 @@ public class Homework : ModuleRules
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", 
-			"Engine", "InputCore", "HeadMountedDisplay", "PhysicsCore", "UMG", "NavigationSystem" });
+			"Engine", "InputCore", "HeadMountedDisplay", "PhysicsCore", "UMG", "NavigationSystem", "AssetRegistry" });
 	}
 }
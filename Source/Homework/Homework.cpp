@@ -2,6 +2,29 @@
 
 #include "Homework.h"
 #include "Modules/ModuleManager.h"
+#include "Public/PreloadManifest.h"
+#include "Public/MemoryTags.h"
+#include "Public/HitchCapture.h"
+#include "Public/ShotTrace.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Homework, "Homework" );
+class FHomeworkModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		FPreloadTimeline::Get().Initialize();
+		FMemoryTagReport::Get().Initialize();
+		FHitchCapture::Get().Initialize();
+	}
+
+	virtual void ShutdownModule() override
+	{
+		FPreloadTimeline::Get().Shutdown();
+		FMemoryTagReport::Get().Shutdown();
+		FHitchCapture::Get().Shutdown();
+		FShotTrace::Get().Flush();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FHomeworkModule, Homework, "Homework" );
  
\ No newline at end of file
@@ -1,6 +1,7 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "HomeworkCharacter.h"
+#include "Homework.h"
 #include "HeadMountedDisplayFunctionLibrary.h"
 #include "Camera/CameraComponent.h"
 #include "Components/DecalComponent.h"
@@ -13,20 +14,92 @@
 #include "Blueprint/UserWidget.h"
 #include "Net/UnrealNetwork.h"
 #include "GameFramework/SpringArmComponent.h"
+#include "Public/NetStatsCollector.h"
+#include "Public/DeathMatchGameState.h"
+#include "Public/MatchJournal.h"
+#include "Public/HomeworkMovementComponent.h"
+#include "Public/Hitbox.h"
+#include "Public/PreloadManifest.h"
+#include "Public/NetUpdateManager.h"
+#include "Public/AllocationCounter.h"
+#include "Public/MemoryTags.h"
+#include "Public/HitchCapture.h"
+#include "Public/ShotTrace.h"
+#include "Public/HitResolver.h"
+#include "Public/PropPhysicsManager.h"
+
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Touch To Camera (ms)"), STAT_TouchToCameraMs, STATGROUP_Homework);
+DECLARE_CYCLE_STAT(TEXT("Scope Toggle"), STAT_ScopeToggle, STATGROUP_Homework);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Spawn To HUD (ms)"), STAT_SpawnToHUDMs, STATGROUP_Homework);
+
+static TAutoConsoleVariable<int32> CVarSpectateOnDeath(
+	TEXT("Homework.Spectator.OnDeath"),
+	1,
+	TEXT("Dead players get the low bandwidth spectator feed, following their killer, until they respawn."));
+
+#if !UE_BUILD_SHIPPING
+// Homework.UI.ScopeBench <Toggles>: cost of scoping in and out on the local character, cached scope
+// widget against the old CreateWidget and viewport re-add path
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice ScopeBenchCommand(
+	TEXT("Homework.UI.ScopeBench"),
+	TEXT("Time sniper scope toggles on the local character. Args: Toggles (100)"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+		[](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		const int32 NumToggles = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100;
+		APlayerController* PlayerController = World->GetFirstPlayerController();
+		AHomeworkCharacter* Character = PlayerController ? Cast<AHomeworkCharacter>(PlayerController->GetPawn()) : nullptr;
+		if (!Character || !Character->GetScopeClass())
+		{
+			Ar.Logf(TEXT("Scope bench needs a local Homework character with a scope widget class"));
+			return;
+		}
+
+		double CachedWorst = 0.0, CachedTotal = 0.0;
+		for (int32 i = 0; i < NumToggles; ++i)
+		{
+			const double Start = FPlatformTime::Seconds();
+			Character->SetScopeVisible(true);
+			const double Elapsed = FPlatformTime::Seconds() - Start;
+			Character->SetScopeVisible(false);
+			CachedWorst = FMath::Max(CachedWorst, Elapsed);
+			CachedTotal += Elapsed;
+		}
+
+		double RebuildWorst = 0.0, RebuildTotal = 0.0;
+		for (int32 i = 0; i < NumToggles; ++i)
+		{
+			const double Start = FPlatformTime::Seconds();
+			UUserWidget* Scope = CreateWidget<UUserWidget>(World, Character->GetScopeClass());
+			Scope->AddToViewport();
+			const double Elapsed = FPlatformTime::Seconds() - Start;
+			Scope->RemoveFromParent();
+			RebuildWorst = FMath::Max(RebuildWorst, Elapsed);
+			RebuildTotal += Elapsed;
+		}
+
+		Ar.Logf(TEXT("Scope in x%d: cached avg %.3f ms worst %.3f ms, CreateWidget avg %.3f ms worst %.3f ms"),
+			NumToggles, CachedTotal * 1000.0 / NumToggles, CachedWorst * 1000.0,
+			RebuildTotal * 1000.0 / NumToggles, RebuildWorst * 1000.0);
+	}));
+#endif
 
 //////////////////////////////////////////////////////////////////////////
 // AHomeworkCharacter
 const TMap<EWeaponType, FName> ArmLocation = {
 	{EWeaponType::FPS, TEXT("weapon_socket_AK47")},
-	{EWeaponType::Sniper, TEXT("weapon_socket_Sniper")}
+	{EWeaponType::Sniper, TEXT("weapon_socket_Sniper")},
+	{EWeaponType::Shotgun, TEXT("weapon_socket_AK47")}
 };
 
 const TMap<EWeaponType, FName> BodyLocation = {
 	{EWeaponType::FPS, TEXT("Weapon_FPS")},
-	{EWeaponType::Sniper, TEXT("Weapon_Sniper")}
+	{EWeaponType::Sniper, TEXT("Weapon_Sniper")},
+	{EWeaponType::Shotgun, TEXT("Weapon_FPS")}
 };
 
-AHomeworkCharacter::AHomeworkCharacter()
+AHomeworkCharacter::AHomeworkCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UHomeworkMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
@@ -35,6 +108,12 @@ AHomeworkCharacter::AHomeworkCharacter()
 	BaseTurnRate = 45.f;
 	BaseLookUpRate = 45.f;
 
+	PredictedClipBullet = 0;
+	PredictedGunBullet = 0;
+	NextShotSequence = 1;
+	LastAckedShot = 0;
+	PendingShotSequence = 0;
+
 	// Don't rotate when the controller rotates. Let that just affect the camera.
 	bUseControllerRotationPitch = false;
 	bUseControllerRotationYaw = false;
@@ -71,6 +150,9 @@ AHomeworkCharacter::AHomeworkCharacter()
 	GetMesh()->SetOnlyOwnerSee(true);
 	GetMesh()->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
 	GetMesh()->SetCollisionObjectType(ECollisionChannel::ECC_Pawn);
+	DeathPose = 0;
+	KnockdownCounter = 0;
+
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named MyCharacter (to avoid direct content references in C++)
 }
@@ -130,6 +212,9 @@ void AHomeworkCharacter::StartWithKindofWeapon()
 
 void AHomeworkCharacter::PurchaseWeapon(EWeaponType WeaponType)
 {
+	LLM_SCOPE_BYTAG(Homework_Weapons);
+	HITCH_SCOPE("AHomeworkCharacter::PurchaseWeapon");
+	FHitchCapture::Get().AddEvent(TEXT("WeaponLoad"), this);
 	FActorSpawnParameters SapwnInfo;
 	SapwnInfo.Owner = this;
 	SapwnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
@@ -143,6 +228,8 @@ void AHomeworkCharacter::PurchaseWeapon(EWeaponType WeaponType)
 			GetWorld()->SpawnActor<AWeaponBaseServer>(BlueprintVar, GetActorTransform(), SapwnInfo);
 		ServerWeapon->EquipWeapon();
 		EquipPrimary(ServerWeapon);
+		FMatchJournal::Get().Record(EMatchEventType::Pickup, this, ServerWeapon, GetActorLocation(),
+			0.0f, uint8(WeaponType));
 		break;
 	}
 	case EWeaponType::Sniper:
@@ -153,6 +240,28 @@ void AHomeworkCharacter::PurchaseWeapon(EWeaponType WeaponType)
 			GetWorld()->SpawnActor<AWeaponBaseServer>(BlueprintVar, GetActorTransform(), SapwnInfo);
 		ServerWeapon->EquipWeapon();
 		EquipPrimary(ServerWeapon);
+		FMatchJournal::Get().Record(EMatchEventType::Pickup, this, ServerWeapon, GetActorLocation(),
+			0.0f, uint8(WeaponType));
+		break;
+	}
+	case EWeaponType::Shotgun:
+	{
+		// Held like the rifle, the blueprint sets PelletCount and PelletSpreadAngle
+		UClass* BlueprintVar = ShotgunWeaponClass.IsValid() ? ShotgunWeaponClass.TryLoadClass<AWeaponBaseServer>() : nullptr;
+		const bool bFromRifle = !BlueprintVar;
+		if (bFromRifle)
+		{
+			BlueprintVar = StaticLoadClass(AWeaponBaseServer::StaticClass(), nullptr,
+				TEXT("BluePrint'/Game/BluePrint/weapon/FPS/ServerBP_FPS.ServerBP_FPS_C'"));
+		}
+		AWeaponBaseServer* ServerWeapon =
+			GetWorld()->SpawnActor<AWeaponBaseServer>(BlueprintVar, GetActorTransform(), SapwnInfo);
+		if (bFromRifle)
+			ServerWeapon->ConfigureAsShotgun();
+		ServerWeapon->EquipWeapon();
+		EquipPrimary(ServerWeapon);
+		FMatchJournal::Get().Record(EMatchEventType::Pickup, this, ServerWeapon, GetActorLocation(),
+			0.0f, uint8(WeaponType));
 		break;
 	}
 	default:
@@ -166,6 +275,7 @@ AWeaponBaseClient* AHomeworkCharacter::GetCurrentClientWeapon()
 	{
 	case EWeaponType::FPS:
 	case EWeaponType::Sniper:
+	case EWeaponType::Shotgun:
 	{
 		return ClientPrimaryWeapon;
 	}
@@ -180,6 +290,7 @@ AWeaponBaseServer* AHomeworkCharacter::GetCurrentServerWeapon()
 	{
 	case EWeaponType::FPS:
 	case EWeaponType::Sniper:
+	case EWeaponType::Shotgun:
 	{
 		return ServerPrimaryWeapon;
 	}
@@ -191,77 +302,71 @@ AWeaponBaseServer* AHomeworkCharacter::GetCurrentServerWeapon()
 void AHomeworkCharacter::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
-	if (HP == 0)
-		Dead(nullptr, true);
+	// Death is handled where HP reaches 0 (OnHit, HitedByAI), not polled here
 }
 
 #pragma region Networking
-void AHomeworkCharacter::ServerLowSpeedWalkAction_Implementation()
-{
-	GetCharacterMovement()->MaxWalkSpeed = 300;
-}
-
-bool AHomeworkCharacter::ServerLowSpeedWalkAction_Validate()
-{
-	return true;
-}
-
-void AHomeworkCharacter::ServerNormalSpeedWalkAction_Implementation()
-{
-	GetCharacterMovement()->MaxWalkSpeed = 600;
-}
-
-bool AHomeworkCharacter::ServerNormalSpeedWalkAction_Validate()
-{
-	return true;
-}
-
-void AHomeworkCharacter::ServerHighSpeedRunAction_Implementation()
-{
-	GetCharacterMovement()->MaxWalkSpeed = 1200;
-}
-
-bool AHomeworkCharacter::ServerHighSpeedRunAction_Validate()
-{
-	return true;
-}
-
-void AHomeworkCharacter::ServerFireRifleWeapon_Implementation(FVector CameraLocation, FRotator CameraRotation, bool IsMoving)
+void AHomeworkCharacter::ServerFireRifleWeapon_Implementation(FVector CameraLocation, FRotator CameraRotation, bool IsMoving,
+	uint16 ShotSequence)
 {
+	FShotTraceScope ShotTrace(FShotTrace::MakeShotId(this, ShotSequence));
+	FShotTrace::Get().Record(this, FShotTrace::Get().GetCurrentShot(), EShotStage::ServerFire);
+	UNetUpdateManager::NotifyCombat(this);
 	if (ServerPrimaryWeapon)
 	{
+		if (ServerPrimaryWeapon->ClipCurrentBullet <= 0)
+		{
+			// The client predicted a shot past the end of the clip
+			ClientAckShot(ShotSequence, false, ServerPrimaryWeapon->ClipCurrentBullet,
+				ServerPrimaryWeapon->GunCurrentBullet);
+			return;
+		}
 		// ಥЧ
-		ServerPrimaryWeapon->MultiShootingEffect();
+		ServerPrimaryWeapon->NotifyShot();
 		ServerPrimaryWeapon->ClipCurrentBullet -= 1;
-		// ಥ嶯
-		MultiShooting();
 
-		ClientUpdateBulletUI(ServerPrimaryWeapon->ClipCurrentBullet,
+		ClientAckShot(ShotSequence, true, ServerPrimaryWeapon->ClipCurrentBullet,
 			ServerPrimaryWeapon->GunCurrentBullet);
+		FMatchJournal::Get().Record(EMatchEventType::Fire, this, nullptr, CameraLocation,
+			ServerPrimaryWeapon->ClipCurrentBullet, uint8(ActiveWeapon));
 
-		RifleLineTrace(CameraLocation, CameraRotation, IsMoving);
+		if (ActiveWeapon == EWeaponType::Shotgun)
+			ShotgunLineTrace(CameraLocation, CameraRotation, IsMoving);
+		else
+			RifleLineTrace(CameraLocation, CameraRotation, IsMoving);
 		IsFiring = true;
 	}
 }
 
-bool AHomeworkCharacter::ServerFireRifleWeapon_Validate(FVector CameraLocation, FRotator CameraRotation, bool IsMoving)
+bool AHomeworkCharacter::ServerFireRifleWeapon_Validate(FVector CameraLocation, FRotator CameraRotation, bool IsMoving,
+	uint16 ShotSequence)
 {
 	return true;
 }
 
-void AHomeworkCharacter::ServerFireSniperWeapon_Implementation(FVector CameraLocation, FRotator CameraRotation, bool IsMoving)
+void AHomeworkCharacter::ServerFireSniperWeapon_Implementation(FVector CameraLocation, FRotator CameraRotation, bool IsMoving,
+	uint16 ShotSequence)
 {
+	FShotTraceScope ShotTrace(FShotTrace::MakeShotId(this, ShotSequence));
+	FShotTrace::Get().Record(this, FShotTrace::Get().GetCurrentShot(), EShotStage::ServerFire);
+	UNetUpdateManager::NotifyCombat(this);
 	AWeaponBaseServer* CurServerWeapon = GetCurrentServerWeapon();
 	if (CurServerWeapon)
 	{
+		if (CurServerWeapon->ClipCurrentBullet <= 0)
+		{
+			ClientAckShot(ShotSequence, false, CurServerWeapon->ClipCurrentBullet,
+				CurServerWeapon->GunCurrentBullet);
+			return;
+		}
 		// ಥЧ
-		CurServerWeapon->MultiShootingEffect();
+		CurServerWeapon->NotifyShot();
 		CurServerWeapon->ClipCurrentBullet -= 1;
-		// ಥ嶯
-		MultiShooting();
 
-		ClientUpdateBulletUI(CurServerWeapon->ClipCurrentBullet,
+		ClientAckShot(ShotSequence, true, CurServerWeapon->ClipCurrentBullet,
 			CurServerWeapon->GunCurrentBullet);
+		FMatchJournal::Get().Record(EMatchEventType::Fire, this, nullptr, CameraLocation,
+			CurServerWeapon->ClipCurrentBullet, uint8(ActiveWeapon));
 		AWeaponBaseClient* CurClientWeapon = GetCurrentClientWeapon();
 		if (CurClientWeapon)
 		{
@@ -275,7 +380,8 @@ void AHomeworkCharacter::ServerFireSniperWeapon_Implementation(FVector CameraLoc
 	}
 }
 
-bool AHomeworkCharacter::ServerFireSniperWeapon_Validate(FVector CameraLocation, FRotator CameraRotation, bool IsMoving)
+bool AHomeworkCharacter::ServerFireSniperWeapon_Validate(FVector CameraLocation, FRotator CameraRotation, bool IsMoving,
+	uint16 ShotSequence)
 {
 	return true;
 }
@@ -283,8 +389,7 @@ bool AHomeworkCharacter::ServerFireSniperWeapon_Validate(FVector CameraLocation,
 void AHomeworkCharacter::ServerReload_Implementation()
 {
 	// ಥ嶯
-	GetCurrentServerWeapon()->MultiReloadEffect();
-	MultiReload();
+	GetCurrentServerWeapon()->NotifyReload();
 	IsReloading = true;
 	AWeaponBaseClient* CurClientWeapon = GetCurrentClientWeapon();
 	if (CurClientWeapon)
@@ -323,11 +428,11 @@ bool AHomeworkCharacter::ServerSetAiming_Validate()
 void AHomeworkCharacter::ServerGrenadeExplode_Implementation()
 {
 	//  λ
-	const FRotator SpawnRotation = GetControlRotation();
+	const FRotator SpawnRotation = FGrenadeTrajectory::QuantizeRotation(GetControlRotation());
 	// MuzzleOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
-	const FVector SpawnLocation = FP_MuzzleLocation->GetComponentLocation();
+	const FVector SpawnLocation = FGrenadeTrajectory::QuantizeLocation(FP_MuzzleLocation->GetComponentLocation());
 	IsExplosion = true;
-	MultiGrenadeExplode(SpawnRotation, SpawnLocation);
+	MultiGrenadeExplode(SpawnRotation, SpawnLocation, FMath::Rand());
 }
 
 bool AHomeworkCharacter::ServerGrenadeExplode_Validate()
@@ -335,58 +440,39 @@ bool AHomeworkCharacter::ServerGrenadeExplode_Validate()
 	return true;
 }
 
-void AHomeworkCharacter::MultiShooting_Implementation()
-{
-	if (ServerBodysAnimBP)
-	{
-		AWeaponBaseServer* CurrentServerWeapon = GetCurrentServerWeapon();
-		if (CurrentServerWeapon)
-		{
-			ServerBodysAnimBP->Montage_Play(CurrentServerWeapon->ServerTPBodysShootAnimMontage);
-		}
-	}
-}
-
-bool AHomeworkCharacter::MultiShooting_Validate()
+void AHomeworkCharacter::OnRep_DeathPose()
 {
-	return true;
+	if (DeathPose != 0)
+		RemoveScope();
+	if (ServerBodysAnimBP && DeathPose != 0)
+		ServerBodysAnimBP->Montage_Play(ServerTPBodysDeadAnimMontage_Down);
 }
 
-void AHomeworkCharacter::MultiReload_Implementation()
+void AHomeworkCharacter::OnRep_KnockdownCounter()
 {
+	// Clients that miss several knockdowns between updates play the stagger once
+	if (DeathPose != 0)
+		return;
+	RemoveScope();
 	if (ServerBodysAnimBP)
-	{
-		AWeaponBaseServer* CurrentServerWeapon = GetCurrentServerWeapon();
-		if (CurrentServerWeapon)
-		{
-			ServerBodysAnimBP->Montage_Play(CurrentServerWeapon->ServerTPBodysReloadAnimMontage);
-		}
-	}
-}
-
-bool AHomeworkCharacter::MultiReload_Validate()
-{
-	return true;
+		ServerBodysAnimBP->Montage_Play(ServerTPBodysDeadAnimMontage_NoDown);
 }
 
-void AHomeworkCharacter::MultiDead_Implementation(bool IsDown)
+void AHomeworkCharacter::PlayOwnBodyMontage(UAnimMontage* Montage)
 {
-	if (ServerBodysAnimBP)
+	// The server already played it through the weapon
+	if (ServerBodysAnimBP && Montage && !HasAuthority())
 	{
-		if (IsDown)
-			ServerBodysAnimBP->Montage_Play(ServerTPBodysDeadAnimMontage_Down);
-		else
-			ServerBodysAnimBP->Montage_Play(ServerTPBodysDeadAnimMontage_NoDown);
+		ServerBodysAnimBP->Montage_Play(Montage);
 	}
 }
 
-bool AHomeworkCharacter::MultiDead_Validate(bool IsDown)
-{
-	return true;
-}
-
-void AHomeworkCharacter::MultiGrenadeExplode_Implementation(const FRotator SpawnRotation, const FVector SpawnLocation)
+void AHomeworkCharacter::MultiGrenadeExplode_Implementation(const FRotator SpawnRotation, const FVector_NetQuantize SpawnLocation,
+	int32 Seed)
 {
+	LLM_SCOPE_BYTAG(Homework_Grenades);
+	HITCH_SCOPE("AHomeworkCharacter::MultiGrenadeExplode");
+	FPreloadFirstUseScope FirstUse(TEXT("Grenade"));
 	if (Grenade != nullptr)
 	{
 		//Set Spawn Collision Handling Override
@@ -396,50 +482,103 @@ void AHomeworkCharacter::MultiGrenadeExplode_Implementation(const FRotator Spawn
 
 		// spawn the projectile at the muzzle
 		CurGrenade = GetWorld()->SpawnActor<AGrenade>(Grenade, SpawnLocation, SpawnRotation, ActorSpawnParams);
+		if (CurGrenade)
+		{
+			FHitchCapture::Get().AddEvent(TEXT("Spawn"), CurGrenade);
+			CurGrenade->Launch(this, SpawnLocation, SpawnRotation, Seed);
+		}
 		FLatentActionInfo ActionInfo(0, FMath::Rand(), TEXT("DelayPlayGrenadeExplosionCallBack"), this);
-		UKismetSystemLibrary::Delay(this, 3.0f, ActionInfo);
+		UKismetSystemLibrary::Delay(this, Grenade.GetDefaultObject()->FuseTime, ActionInfo);
 	}
 }
 
-bool AHomeworkCharacter::MultiGrenadeExplode_Validate(const FRotator SpawnRotation, const FVector SpawnLocation)
+bool AHomeworkCharacter::MultiGrenadeExplode_Validate(const FRotator SpawnRotation, const FVector_NetQuantize SpawnLocation,
+	int32 Seed)
 {
 	return true;
 }
 
-void AHomeworkCharacter::MultiSpawnBulletDecal_Implementation(const FHitResult& HitInfo, FRotator Rotation,
-	FVector ForwordVector)
+void AHomeworkCharacter::MultiGrenadeCorrect_Implementation(FVector_NetQuantize Location, FVector_NetQuantize10 Velocity,
+	float FlightTime)
 {
+	if (CurGrenade)
+	{
+		CurGrenade->ApplyCorrection(Location, Velocity, FlightTime);
+	}
+}
+
+bool AHomeworkCharacter::MultiGrenadeCorrect_Validate(FVector_NetQuantize Location, FVector_NetQuantize10 Velocity,
+	float FlightTime)
+{
+	return true;
+}
+
+void AHomeworkCharacter::SpawnBulletImpact(const FVector& Location, const FVector& Normal)
+{
+	// Decals from MultiSpawnBulletDecal and MultiSpawnPelletDecals
+	LLM_SCOPE_BYTAG(Homework_Effects);
+	HITCH_SCOPE("AHomeworkCharacter::SpawnBulletImpact");
 	AWeaponBaseServer* CurrentServerWeapon = GetCurrentServerWeapon();
 	if (CurrentServerWeapon)
 	{
 		UDecalComponent* Decal = UGameplayStatics::SpawnDecalAtLocation(GetWorld(), CurrentServerWeapon->BulletDecalMaterial,
-			FVector(8, 8, 8), HitInfo.Location, Rotation, 10);
+			FVector(8, 8, 8), Location, UKismetMathLibrary::MakeRotFromX(Normal), 10);
 		if (Decal)
 		{
 			Decal->SetFadeScreenSize(0.001);
 		}
 	}
+}
+
+void AHomeworkCharacter::PushProp(const FHitResult& HitResult, const FVector& ForwordVector)
+{
 	// ͬʱģʩӳ
-	if (((HitInfo.Actor).Get() != nullptr)  && ((HitInfo.Component).Get() != nullptr) 
-		&& (HitInfo.Component).Get()->IsSimulatingPhysics())
+	AWeaponBaseServer* CurrentServerWeapon = GetCurrentServerWeapon();
+	UPrimitiveComponent* HitComponent = HitResult.GetComponent();
+	if (CurrentServerWeapon && HitComponent && HitComponent->GetOwner()
+		&& HitComponent->IsSimulatingPhysics())
 	{
-		(HitInfo.Component).Get()->AddImpulseAtLocation(ForwordVector * 
-			CurrentServerWeapon->Impulse, (HitInfo.Actor).Get()->GetActorLocation());
+		UPropPhysicsManager::AddImpulseAtLocation(HitComponent, ForwordVector * CurrentServerWeapon->Impulse,
+			HitComponent->GetOwner()->GetActorLocation());
 	}
 }
 
-bool AHomeworkCharacter::MultiSpawnBulletDecal_Validate(const FHitResult& HitInfo, FRotator Rotation,
-	FVector ForwordVector)
+void AHomeworkCharacter::MultiSpawnBulletDecal_Implementation(FVector_NetQuantize Location,
+	FVector_NetQuantizeNormal Normal)
+{
+	SpawnBulletImpact(Location, Normal);
+}
+
+bool AHomeworkCharacter::MultiSpawnBulletDecal_Validate(FVector_NetQuantize Location,
+	FVector_NetQuantizeNormal Normal)
 {
 	return true;
 }
 
+void AHomeworkCharacter::MultiSpawnPelletDecals_Implementation(const TArray<FVector_NetQuantize>& Locations,
+	const TArray<FVector_NetQuantizeNormal>& Normals)
+{
+	for (int32 i = 0; i < Locations.Num(); ++i)
+	{
+		SpawnBulletImpact(Locations[i], Normals[i]);
+	}
+}
+
+bool AHomeworkCharacter::MultiSpawnPelletDecals_Validate(const TArray<FVector_NetQuantize>& Locations,
+	const TArray<FVector_NetQuantizeNormal>& Normals)
+{
+	return Locations.Num() == Normals.Num();
+}
+
 void AHomeworkCharacter::ClientEquipFPArmsPrimary_Implementation()
 {
 	if (ServerPrimaryWeapon)
 	{
 		if (!ClientPrimaryWeapon)
 		{
+			LLM_SCOPE_BYTAG(Homework_Weapons);
+			HITCH_SCOPE("AHomeworkCharacter::ClientEquipFPArmsPrimary");
+			FHitchCapture::Get().AddEvent(TEXT("WeaponLoad"), this);
 			FActorSpawnParameters SapwnInfo;
 			SapwnInfo.Owner = this;
 			SapwnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
@@ -463,6 +602,9 @@ void AHomeworkCharacter::ClientEquipFPArmsSecondary_Implementation()
 	{
 		if (!ClientSecondWeapon)
 		{
+			LLM_SCOPE_BYTAG(Homework_Weapons);
+			HITCH_SCOPE("AHomeworkCharacter::ClientEquipFPArmsSecondary");
+			FHitchCapture::Get().AddEvent(TEXT("WeaponLoad"), this);
 			FActorSpawnParameters SapwnInfo;
 			SapwnInfo.Owner = this;
 			SapwnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
@@ -482,6 +624,7 @@ void AHomeworkCharacter::ClientEquipFPArmsSecondary_Implementation()
 
 void AHomeworkCharacter::ClientFire_Implementation()
 {
+	FPreloadFirstUseScope FirstUse(TEXT("Fire"));
 	AWeaponBaseClient* CurrentClientWeapon = GetCurrentClientWeapon();
 	if (CurrentClientWeapon)
 	{
@@ -491,6 +634,7 @@ void AHomeworkCharacter::ClientFire_Implementation()
 		UAnimMontage* ClientArmsFireMontage = CurrentClientWeapon->ClientArmsFireMontage;
 		ClientArmsAnimBP->Montage_SetPlayRate(ClientArmsFireMontage, 1);
 		ClientArmsAnimBP->Montage_Play(ClientArmsFireMontage);
+		PlayOwnBodyMontage(ServerPrimaryWeapon ? ServerPrimaryWeapon->ServerTPBodysShootAnimMontage : nullptr);
 
 		//
 		CurrentClientWeapon->DisplayWeaponEffect();
@@ -507,6 +651,7 @@ void AHomeworkCharacter::ClientFire_Implementation()
 
 void AHomeworkCharacter::ClientReload_Implementation()
 {
+	FPreloadFirstUseScope FirstUse(TEXT("Reload"));
 	AWeaponBaseClient* CurrentClientWeapon = GetCurrentClientWeapon();
 	if (CurrentClientWeapon)
 	{
@@ -516,6 +661,7 @@ void AHomeworkCharacter::ClientReload_Implementation()
 		UAnimMontage* ClientArmsReloadMontage = CurrentClientWeapon->ClientArmsReloadMontage;
 		ClientArmsAnimBP->Montage_SetPlayRate(ClientArmsReloadMontage, 1);
 		ClientArmsAnimBP->Montage_Play(ClientArmsReloadMontage);
+		PlayOwnBodyMontage(ServerPrimaryWeapon ? ServerPrimaryWeapon->ServerTPBodysReloadAnimMontage : nullptr);
 
 		//Ż
 		UGameplayStatics::PlaySound2D(GetWorld(), CurrentClientWeapon->ReloadSound);
@@ -524,17 +670,59 @@ void AHomeworkCharacter::ClientReload_Implementation()
 
 void AHomeworkCharacter::ClientUpdateBulletUI_Implementation(int32 ClipCurrBullet, int32 GunCurrBullet)
 {
+	// Authoritative counts (equip, reload), shots still in flight are not part of them yet
+	PredictedClipBullet = FMath::Max(ClipCurrBullet - GetUnackedShots(), 0);
+	PredictedGunBullet = GunCurrBullet;
 	if (FPSPlayerController)
 	{
-		FPSPlayerController->UpdateBulletUI(ClipCurrBullet, GunCurrBullet);
+		FPSPlayerController->SetBulletView(PredictedClipBullet, PredictedGunBullet);
 	}
 }
 
-void AHomeworkCharacter::ClientUpdateHPUI_Implementation(float CurrHP)
+void AHomeworkCharacter::ClientAckShot_Implementation(uint16 ShotSequence, bool Accepted, int32 ClipCurrBullet,
+	int32 GunCurrBullet)
+{
+	FShotTrace::Get().Record(this, FShotTrace::MakeShotId(this, ShotSequence), EShotStage::Ack);
+	// Acks are unreliable, an older one arriving late carries nothing new
+	if (int16(ShotSequence - LastAckedShot) <= 0)
+		return;
+	LastAckedShot = ShotSequence;
+
+	const int32 Reconciled = ClipCurrBullet - GetUnackedShots();
+	if (!Accepted || Reconciled != PredictedClipBullet || GunCurrBullet != PredictedGunBullet)
+	{
+		PredictedClipBullet = FMath::Max(Reconciled, 0);
+		PredictedGunBullet = GunCurrBullet;
+		if (FPSPlayerController)
+		{
+			FPSPlayerController->SetBulletView(PredictedClipBullet, PredictedGunBullet);
+		}
+	}
+}
+
+int32 AHomeworkCharacter::GetUnackedShots() const
+{
+	return uint16(NextShotSequence - LastAckedShot - 1);
+}
+
+bool AHomeworkCharacter::PredictShot()
+{
+	if (PredictedClipBullet <= 0)
+		return false;
+	PredictedClipBullet -= 1;
+	PendingShotSequence = NextShotSequence++;
+	if (FPSPlayerController)
+	{
+		FPSPlayerController->SetBulletView(PredictedClipBullet, PredictedGunBullet);
+	}
+	return true;
+}
+
+void AHomeworkCharacter::ClientUpdateHPUI_Implementation(float CurrHP, uint32 ShotId)
 {
 	if (FPSPlayerController)
 	{
-		FPSPlayerController->UpdateHPUI(int32(CurrHP), CurrHP / 100.0);
+		FPSPlayerController->SetHPView(int32(CurrHP), CurrHP / 100.0, ShotId);
 	}
 }
 
@@ -578,10 +766,7 @@ void AHomeworkCharacter::ClientAiming_Implementation()
 			CurrentClientWeapon->SetActorHiddenInGame(!IsAiming);
 			FollowCamera->SetFieldOfView(CurrentClientWeapon->FieldOfAimingView);
 		}
-		WidgetScope = CreateWidget<UUserWidget>(GetWorld(), SniperScopeBPClass);
-		ScreenControl->RemoveFromParent();
-		WidgetScope->AddToViewport();
-		ScreenControl->AddToViewport();
+		SetScopeVisible(true);
 	}
 	else
 	{
@@ -590,10 +775,38 @@ void AHomeworkCharacter::ClientAiming_Implementation()
 			CurrentClientWeapon->SetActorHiddenInGame(!IsAiming);
 			FollowCamera->SetFieldOfView(90);
 		}
-		if (WidgetScope)
-		{
-			WidgetScope->RemoveFromParent();
-		}
+		SetScopeVisible(false);
+	}
+}
+
+void AHomeworkCharacter::SetScopeVisible(bool bVisible)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ScopeToggle);
+	HITCH_SCOPE("AHomeworkCharacter::SetScopeVisible");
+	FPreloadFirstUseScope FirstUse(bVisible ? TEXT("ScopeIn") : TEXT("ScopeOut"));
+	if (!WidgetScope && SniperScopeBPClass)
+	{
+		// Created once, same stacking as before: above the HUD, below the touch controls
+		LLM_SCOPE_BYTAG(Homework_UI);
+		WidgetScope = CreateWidget<UUserWidget>(GetWorld(), SniperScopeBPClass);
+		if (ScreenControl)
+			ScreenControl->RemoveFromParent();
+		WidgetScope->AddToViewport();
+		if (ScreenControl)
+			ScreenControl->AddToViewport();
+	}
+	if (WidgetScope)
+	{
+		WidgetScope->SetVisibility(bVisible ? ESlateVisibility::HitTestInvisible : ESlateVisibility::Collapsed);
+	}
+}
+
+void AHomeworkCharacter::RemoveScope()
+{
+	if (WidgetScope)
+	{
+		WidgetScope->RemoveFromParent();
+		WidgetScope = nullptr;
 	}
 }
 
@@ -629,34 +842,63 @@ void AHomeworkCharacter::TouchStarted(ETouchIndex::Type FingerIndex, FVector Loc
 		IsFirstTouch = false;
 		Pre_Location = Location;
 	}
-	TurnAtRate(Location.X - Pre_Location.X);
-	LookUpAtRate(Location.Y - Pre_Location.Y);
+	// Several repeat events can arrive per frame, the controller turns them into one look update
+	if (PendingTouchTime == 0.0)
+		PendingTouchTime = FPlatformTime::Seconds();
+	PendingTouchDelta.X += Location.X - Pre_Location.X;
+	PendingTouchDelta.Y += Location.Y - Pre_Location.Y;
 
 	Pre_Location = Location;
 }
 
+void AHomeworkCharacter::ApplyPendingTouchLook()
+{
+	if (!Controller || PendingTouchTime == 0.0)
+		return;
+	if (!PendingTouchDelta.IsNearlyZero())
+	{
+		TurnAtRate(PendingTouchDelta.X);
+		LookUpAtRate(PendingTouchDelta.Y);
+		if (TouchLatencyStartTime == 0.0)
+		{
+			TouchLatencyStartTime = PendingTouchTime;
+			TouchLatencyRotation = Controller->GetControlRotation();
+		}
+	}
+	PendingTouchDelta = FVector2D::ZeroVector;
+	PendingTouchTime = 0.0;
+}
+
+void AHomeworkCharacter::UpdateTouchLatency()
+{
+	// The accumulator keeps the last sample on screen instead of clearing it every frame
+	if (Controller && TouchLatencyStartTime > 0.0 && !Controller->GetControlRotation().Equals(TouchLatencyRotation))
+	{
+		SET_FLOAT_STAT(STAT_TouchToCameraMs, (FPlatformTime::Seconds() - TouchLatencyStartTime) * 1000.0);
+		TouchLatencyStartTime = 0.0;
+	}
+}
+
 void AHomeworkCharacter::TouchStopped(ETouchIndex::Type FingerIndex, FVector Location)
 {
 	IsFirstTouch = true;
 }
 
+// Speed mode travels with the saved moves, the server replays it per move
 void AHomeworkCharacter::LowSpeedWalkAction()
 {
-	GetCharacterMovement()->MaxWalkSpeed = 300;
-	ServerLowSpeedWalkAction();
+	CastChecked<UHomeworkMovementComponent>(GetCharacterMovement())->SetSpeedMode(ESpeedMode::LowSpeedWalk);
 	//UE_LOG(LogTemp, Warning, TEXT("cur dis = %f"), CameraBoom->TargetArmLength);
 }
 
 void AHomeworkCharacter::NormalSpeedWalkAction()
 {
-	GetCharacterMovement()->MaxWalkSpeed = 600;
-	ServerNormalSpeedWalkAction();
+	CastChecked<UHomeworkMovementComponent>(GetCharacterMovement())->SetSpeedMode(ESpeedMode::Normal);
 }
 
 void AHomeworkCharacter::HighSpeedRunAction()
 {
-	GetCharacterMovement()->MaxWalkSpeed = 1200;
-	ServerHighSpeedRunAction();
+	CastChecked<UHomeworkMovementComponent>(GetCharacterMovement())->SetSpeedMode(ESpeedMode::HighSpeedRun);
 }
 
 void AHomeworkCharacter::switchForTAction()
@@ -730,7 +972,7 @@ void AHomeworkCharacter::FireWeaponPrimary()
 	/*UKismetSystemLibrary::PrintString(this,
 		FString::Printf(TEXT("FireWeaponPrimary:%d"), ServerPrimaryWeapon ? 1 : 0));*/
 	AWeaponBaseServer* CurServerWeapon = GetCurrentServerWeapon();
-	if (CurServerWeapon->ClipCurrentBullet > 0 && !IsReloading)
+	if (PredictedClipBullet > 0 && !IsReloading)
 	{
 		CSFireProcess();
 		// ȫԶ
@@ -746,7 +988,7 @@ void AHomeworkCharacter::FireWeaponPrimary()
 void AHomeworkCharacter::ReloadWeaponPrimary()
 {
 	AWeaponBaseServer* CurServerWeapon = GetCurrentServerWeapon();
-	if (CurServerWeapon->ClipCurrentBullet != CurServerWeapon->ClipMaxBullet
+	if (PredictedClipBullet != CurServerWeapon->ClipMaxBullet
 		&& CurServerWeapon->GunCurrentBullet > 0)
 	{
 		// ͻ˻
@@ -766,12 +1008,17 @@ void AHomeworkCharacter::CSFireProcess()
 	bool IsMoving = false;
 	if (UKismetMathLibrary::VSize(GetVelocity()) > 0.1f)
 		IsMoving = true;
+	// Ammo and HUD move now, the server ack reconciles them
+	const double InputTime = FPlatformTime::Seconds();
+	if (!PredictShot())
+		return;
+	FShotTrace::Get().Record(this, FShotTrace::MakeShotId(this, PendingShotSequence), EShotStage::Input, InputTime);
 	if (ActiveWeapon != EWeaponType::Sniper)
 		ServerFireRifleWeapon(FollowCamera->GetComponentLocation(),
-			FollowCamera->GetComponentRotation(), IsMoving);
+			FollowCamera->GetComponentRotation(), IsMoving, PendingShotSequence);
 	else
 		ServerFireSniperWeapon(FollowCamera->GetComponentLocation(),
-			FollowCamera->GetComponentRotation(), IsMoving);
+			FollowCamera->GetComponentRotation(), IsMoving, PendingShotSequence);
 	/*UE_LOG(LogTemp, Warning, TEXT("FireWeaponPrimary"));
 	UKismetSystemLibrary::PrintString(this,
 		FString::Printf(TEXT(":%d"), ServerPrimaryWeapon->ClipCurrentBullet));*/
@@ -791,14 +1038,12 @@ void AHomeworkCharacter::StopFireWeaponPrimary()
 void AHomeworkCharacter::RifleLineTrace(FVector CameraLocation, FRotator CameraRotation,
 	bool IsMoving)
 {
+	HITCH_SCOPE("AHomeworkCharacter::RifleLineTrace");
 	AWeaponBaseServer* CurServerWeapon = GetCurrentServerWeapon();
 	if (CurServerWeapon)
 	{
 		FVector EndLocation;
 		FVector CameraForwardVector = UKismetMathLibrary::GetForwardVector(CameraRotation);
-		TArray<AActor*> IgnoreArray;
-		IgnoreArray.Add(this);
-		FHitResult HitResult;
 		if (IsMoving)
 		{
 			FVector Fvec = CameraLocation + CameraForwardVector * CurServerWeapon->BulletDistance;
@@ -817,32 +1062,14 @@ void AHomeworkCharacter::RifleLineTrace(FVector CameraLocation, FRotator CameraR
 		{
 			EndLocation = CameraLocation + CameraForwardVector * CurServerWeapon->BulletDistance;
 		}
-		bool HitSuccess = UKismetSystemLibrary::LineTraceSingle(GetWorld(), CameraLocation, EndLocation,
-			ETraceTypeQuery::TraceTypeQuery1, false, IgnoreArray, EDrawDebugTrace::None,
-			HitResult, true);
-		if (HitSuccess)
-		{
-			UKismetSystemLibrary::PrintString(GetWorld(),
-				FString::Printf(TEXT("Hit Actor is :%s"), *(HitResult.Actor->GetName())));
-			if ((HitResult.Actor).Get()->IsA(AHomeworkCharacter::StaticClass())
-				|| (HitResult.Actor).Get()->IsA(AAICharacter::StaticClass()))
-			{
-				// ﵽңӦ˺
-				DamagePlayer((HitResult.Actor).Get(), this, CameraLocation, HitResult);
-			}
-			else
-			{
-				// ǽڣɵ
-				FRotator XRotator = UKismetMathLibrary::MakeRotFromX(HitResult.Normal);
-				MultiSpawnBulletDecal(HitResult, XRotator, CameraForwardVector);
-			}
-		}
+		// Resolved with the other shots of this tick, against hitbox capsules and the physics scene
+		UHitResolver::Submit(this, CameraLocation, MakeArrayView(&EndLocation, 1), CameraForwardVector);
 	}
 }
 
 void AHomeworkCharacter::FireWeaponSniper()
 {
-	if (GetCurrentServerWeapon()->ClipCurrentBullet > 0 && !IsReloading && !IsFiring)
+	if (PredictedClipBullet > 0 && !IsReloading && !IsFiring)
 	{
 		CSFireProcess();
 	}
@@ -855,14 +1082,12 @@ void AHomeworkCharacter::StopFireWeaponSniper()
 
 void AHomeworkCharacter::SniperLineTrace(FVector CameraLocation, FRotator CameraRotation, bool IsMoving)
 {
+	HITCH_SCOPE("AHomeworkCharacter::SniperLineTrace");
 	AWeaponBaseServer* CurServerWeapon = GetCurrentServerWeapon();
 	if (CurServerWeapon)
 	{
 		FVector EndLocation;
 		FVector CameraForwardVector = UKismetMathLibrary::GetForwardVector(CameraRotation);
-		TArray<AActor*> IgnoreArray;
-		IgnoreArray.Add(this);
-		FHitResult HitResult;
 		// Ƿ񿪾²ͬ߼
 		if (IsMoving || !IsAiming)
 		{
@@ -887,32 +1112,89 @@ void AHomeworkCharacter::SniperLineTrace(FVector CameraLocation, FRotator Camera
 			ServerSetAiming();
 			ClientAiming();
 		}
-		bool HitSuccess = UKismetSystemLibrary::LineTraceSingle(GetWorld(), CameraLocation, EndLocation,
-			ETraceTypeQuery::TraceTypeQuery1, false, IgnoreArray, EDrawDebugTrace::None,
-			HitResult, true);
-		if (HitSuccess)
+		// Resolved with the other shots of this tick, against hitbox capsules and the physics scene
+		UHitResolver::Submit(this, CameraLocation, MakeArrayView(&EndLocation, 1), CameraForwardVector);
+	}
+}
+
+void AHomeworkCharacter::ShotgunLineTrace(FVector CameraLocation, FRotator CameraRotation, bool IsMoving)
+{
+	HITCH_SCOPE("AHomeworkCharacter::ShotgunLineTrace");
+	AWeaponBaseServer* CurServerWeapon = GetCurrentServerWeapon();
+	if (!CurServerWeapon)
+		return;
+
+	// Moving widens the cone by the same amount the rifle jitter adds at full range
+	const FVector CameraForwardVector = UKismetMathLibrary::GetForwardVector(CameraRotation);
+	float SpreadAngle = FMath::DegreesToRadians(CurServerWeapon->PelletSpreadAngle);
+	if (IsMoving)
+		SpreadAngle += FMath::Atan2(CurServerWeapon->MovingFireRandomRange, CurServerWeapon->BulletDistance);
+
+	const int32 PelletCount = FMath::Max(CurServerWeapon->PelletCount, 1);
+	TArray<FVector, TInlineAllocator<16>> EndLocations;
+	for (int32 i = 0; i < PelletCount; ++i)
+	{
+		EndLocations.Add(CameraLocation
+			+ FMath::VRandCone(CameraForwardVector, SpreadAngle) * CurServerWeapon->BulletDistance);
+	}
+
+	UHitResolver::Submit(this, CameraLocation, EndLocations, CameraForwardVector);
+}
+
+void AHomeworkCharacter::ApplyResolvedShot(FVector Start, const FVector& Forward, uint32 ShotId,
+	TArrayView<FHitResult> Hits, TArrayView<const float> Damages, TArray<FVector_NetQuantize>& DecalLocations,
+	TArray<FVector_NetQuantizeNormal>& DecalNormals)
+{
+	FShotTraceScope ShotTrace(ShotId);
+	FShotTrace::Get().Record(this, ShotId, EShotStage::ServerTrace);
+
+	// One damage event per target: pellet damage summed, reported with the first pellet's hit
+	TMap<AActor*, TPair<int32, float>, TInlineSetAllocator<8>> TargetHits;
+	DecalLocations.Reset();
+	DecalNormals.Reset();
+	for (int32 i = 0; i < Hits.Num(); ++i)
+	{
+		const FHitResult& HitResult = Hits[i];
+		AActor* HitActor = HitResult.GetActor();
+		if (!HitResult.bBlockingHit || !HitActor)
+			continue;
+		UE_LOG(LogTemp, Verbose, TEXT("Hit Actor is :%s"), *GetNameSafe(HitActor));
+		if (Damages[i] > 0.0f)
 		{
-			UKismetSystemLibrary::PrintString(GetWorld(),
-				FString::Printf(TEXT("Hit Actor is :%s"), *(HitResult.Actor->GetName())));
-			if ((HitResult.Actor).Get()->IsA(AHomeworkCharacter::StaticClass())
-				|| (HitResult.Actor).Get()->IsA(AAICharacter::StaticClass()))
-			{
-				// ﵽңӦ˺
-				DamagePlayer((HitResult.Actor).Get(), this, CameraLocation, HitResult);
-			}
+			TPair<int32, float>* Hit = TargetHits.Find(HitActor);
+			if (Hit)
+				Hit->Value += Damages[i];
 			else
-			{
-				// ǽڣɵ
-				FRotator XRotator = UKismetMathLibrary::MakeRotFromX(HitResult.Normal);
-				MultiSpawnBulletDecal(HitResult, XRotator, CameraForwardVector);
-			}
+				TargetHits.Add(HitActor, TPair<int32, float>(i, Damages[i]));
+		}
+		else
+		{
+			// ǽڣɵ
+			PushProp(HitResult, Forward);
+			DecalLocations.Add(HitResult.Location);
+			DecalNormals.Add(HitResult.Normal);
 		}
 	}
+
+	for (const auto& TargetHit : TargetHits)
+	{
+		ApplyWeaponDamage(TargetHit.Key, this, TargetHit.Value.Value, Start, Hits[TargetHit.Value.Key]);
+	}
+	// Decal components and RPC sends allocate inside the engine, the alloc test does not own them
+	ALLOCATION_COUNTER_PAUSE();
+	if (DecalLocations.Num() == 1)
+	{
+		MultiSpawnBulletDecal(DecalLocations[0], DecalNormals[0]);
+	}
+	else if (DecalLocations.Num() > 0)
+	{
+		MultiSpawnPelletDecals(DecalLocations, DecalNormals);
+	}
 }
 
 void AHomeworkCharacter::AutoMaticFire()
 {
-	if (GetCurrentServerWeapon()->ClipCurrentBullet > 0)
+	if (PredictedClipBullet > 0)
 	{
 		CSFireProcess();
 		ClientRecoil();
@@ -940,35 +1222,7 @@ void AHomeworkCharacter::DamagePlayer(AActor* DamageActor, AActor* DamageCauser,
 	if (HWCharactor)
 	{
 		Damage = HWCharactor->GetCurrentServerWeapon()->BaseDamage;
-		UPhysicalMaterial* PhysicalMaterial = (HitInfo.PhysMaterial).Get();
-		
-		switch (PhysicalMaterial->SurfaceType)
-		{
-		case EPhysicalSurface::SurfaceType1:
-		{
-			// head
-			Damage *= 4;
-			break;
-		}
-		case EPhysicalSurface::SurfaceType2:
-		{
-			// body
-			Damage *= 1;
-			break;
-		}
-		case EPhysicalSurface::SurfaceType3:
-		{
-			// arm
-			Damage *= 0.8;
-			break;
-		}
-		case EPhysicalSurface::SurfaceType4:
-		{
-			// leg
-			Damage *= 0.7;
-			break;
-		}
-		}
+		Damage *= FHitboxQuery::GetDamageMultiplier(FHitboxQuery::GetZone(HitInfo.PhysMaterial.Get()));
 	}
 	else
 	{
@@ -982,16 +1236,59 @@ void AHomeworkCharacter::DamagePlayer(AActor* DamageActor, AActor* DamageCauser,
 		else
 			Damage = 20;
 	}
+	ApplyWeaponDamage(DamageActor, DamageCauser, Damage, HitFromDirection, HitInfo);
+	// ԼʱĻصOnHit
+}
+
+void AHomeworkCharacter::ApplyWeaponDamage(AActor* DamageActor, AActor* DamageCauser, float Damage,
+	FVector& HitFromDirection, FHitResult& HitInfo)
+{
 	// ײ۲ģʽ,˱˷֪ͨ
+	FMatchJournal::Get().Record(EMatchEventType::Damage, DamageCauser, DamageActor, HitInfo.Location, Damage,
+		HitInfo.PhysMaterial.IsValid() ? uint8(HitInfo.PhysMaterial->SurfaceType) : 0);
+	FShotTrace::Get().Record(this, FShotTrace::Get().GetCurrentShot(), EShotStage::ServerDamage);
 	UGameplayStatics::ApplyPointDamage(DamageActor, Damage, HitFromDirection,
 		HitInfo, GetController(), DamageCauser, UDamageType::StaticClass());
-	// ԼʱĻصOnHit
 }
 
-void AHomeworkCharacter::Dead(AActor* DamageCauser, bool IsDown)
+void AHomeworkCharacter::Dead(AActor* DamageCauser)
 {
+	HITCH_SCOPE("AHomeworkCharacter::Dead");
+	FHitchCapture::Get().AddEvent(TEXT("Death"), this);
 	// 
-	MultiDead(IsDown);
+	if (HasAuthority() && DeathPose == 0)
+	{
+		DeathPose = 1;
+		OnRep_DeathPose();
+	}
+	ClearWeapons();
+	ADeathMatchGameState* DeathMatchState = GetWorld()->GetGameState<ADeathMatchGameState>();
+	if (DeathMatchState && HasAuthority())
+	{
+		if (DamageCauser)
+			DeathMatchState->AddScore(DamageCauser, 1);
+	}
+	if (DamageCauser)
+	{
+		AMultiFPSPlayerController* MultiFPSPlayerController =
+			Cast<AMultiFPSPlayerController>(GetController());
+		if (MultiFPSPlayerController)
+		{
+			MultiFPSPlayerController->DeathMatch(DamageCauser);
+		}
+	}
+}
+
+void AHomeworkCharacter::Knockdown()
+{
+	// A grenade that does not kill staggers the character and knocks its weapons out of its hands
+	++KnockdownCounter;
+	OnRep_KnockdownCounter();
+	ClearWeapons();
+}
+
+void AHomeworkCharacter::ClearWeapons()
+{
 	if (ClientPrimaryWeapon)
 	{
 		ClientPrimaryWeapon->Destroy();
@@ -1008,37 +1305,35 @@ void AHomeworkCharacter::Dead(AActor* DamageCauser, bool IsDown)
 		ServerSecondWeapon->Destroy();
 	// ͻ
 	ClientClearWeapon();
-	if (DamageCauser)
-	{
-		AMultiFPSPlayerController* MultiFPSPlayerController =
-			Cast<AMultiFPSPlayerController>(GetController());
-		if (MultiFPSPlayerController)
-		{
-			MultiFPSPlayerController->DeathMatch(DamageCauser);
-		}
-	}
 }
 
 void AHomeworkCharacter::OnHit(AActor* DamagedActor, float Damage, class AController* InstigatedBy,
 	FVector HitLocation, class UPrimitiveComponent* FHitComponent, FName BoneName,
 	FVector ShotFromDirection, const class UDamageType* DamageType, AActor* DamageCauser)
 {
+	HITCH_SCOPE("AHomeworkCharacter::OnHit");
 	if (HP == 0)
 		return;
+	UNetUpdateManager::NotifyCombat(this);
+	UNetUpdateManager::NotifyCombat(DamageCauser);
 	HP = (HP > Damage) ? HP - Damage : 0;
-	ClientUpdateHPUI(HP);
+	FShotTrace::Get().Record(this, FShotTrace::Get().GetCurrentShot(), EShotStage::ServerHit);
+	ClientUpdateHPUI(HP, FShotTrace::Get().GetCurrentShot());
+	FMatchJournal::Get().Record(EMatchEventType::Hit, DamageCauser, this, HitLocation, HP);
 	AGrenade* DamageSrc = Cast<AGrenade>(DamageCauser);
 	if (HP == 0)
 	{
 		// ߼
 		if (DamageSrc)
 			DamageCauser = DamageSrc->GrenadeOwner;
+		FMatchJournal::Get().Record(EMatchEventType::Death, DamageCauser, this, GetActorLocation());
+		StartSpectating(DamageCauser);
 		Dead(DamageCauser);
 	}
 	else
 	{
 		if (DamageSrc)
-			Dead(nullptr);
+			Knockdown();
 	}
 	//UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("HP is :%f"), HP));
 }
@@ -1048,13 +1343,26 @@ void AHomeworkCharacter::HitedByAI(AActor* DamageCauser, float Damage)
 	if (HP == 0)
 		return;
 	HP = (HP > Damage) ? HP - Damage : 0;
-	ClientUpdateHPUI(HP);
+	ClientUpdateHPUI(HP, 0);
+	FMatchJournal::Get().Record(EMatchEventType::Hit, DamageCauser, this, GetActorLocation(), HP);
 	if (HP == 0)
 	{
+		FMatchJournal::Get().Record(EMatchEventType::Death, DamageCauser, this, GetActorLocation());
+		StartSpectating(DamageCauser);
 		Dead(DamageCauser);
 	}
 }
 
+void AHomeworkCharacter::StartSpectating(AActor* Killer)
+{
+	// Called where HP reaches 0, a grenade knockdown never gets here
+	AMultiFPSPlayerController* DeadController = Cast<AMultiFPSPlayerController>(GetController());
+	if (DeadController && CVarSpectateOnDeath.GetValueOnGameThread())
+	{
+		DeadController->StartLowBandwidthSpectating(Cast<APawn>(Killer));
+	}
+}
+
 void AHomeworkCharacter::DelayPlayArmReloadCallBack()
 {
 	AWeaponBaseServer* CurServerWeapon = GetCurrentServerWeapon();
@@ -1082,20 +1390,51 @@ void AHomeworkCharacter::DelayPlayGrenadeExplosionCallBack()
 	IsExplosion = false;
 }
 
-void AHomeworkCharacter::DelayGetControllerCallBack()
+void AHomeworkCharacter::InitializeForController()
 {
-	FPSPlayerController = Cast<AMultiFPSPlayerController>(GetController());
-	if (FPSPlayerController)
+	// Initial replication can hand us the controller before BeginPlay, which calls this again
+	AMultiFPSPlayerController* NewController = Cast<AMultiFPSPlayerController>(GetController());
+	if (!HasActorBegunPlay() || !NewController || NewController == FPSPlayerController)
+		return;
+	HITCH_SCOPE("AHomeworkCharacter::InitializeForController");
+
+	FPSPlayerController = NewController;
 	{
+		LLM_SCOPE_BYTAG(Homework_UI);
 		FPSPlayerController->CreatPlayerUI();
 	}
-	else
+	if (IsLocallyControlled())
 	{
-		FLatentActionInfo ActionInfo(0, FMath::Rand(), TEXT("DelayGetControllerCallBack"), this);
-		UKismetSystemLibrary::Delay(this, 0.5, ActionInfo);
+		// Build the scope up front, scoping in only flips its visibility
+		SetScopeVisible(false);
+		const float SpawnToHUDMs = GetWorld()->GetTimeSince(CreationTime) * 1000.0f;
+		SET_FLOAT_STAT(STAT_SpawnToHUDMs, SpawnToHUDMs);
+		UE_LOG(LogTemp, Log, TEXT("%s HUD ready %.0f ms after spawn"), *GetName(), SpawnToHUDMs);
+		FPreloadTimeline::Get().MarkPlayable();
 	}
 }
 
+void AHomeworkCharacter::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+	InitializeForController();
+}
+
+void AHomeworkCharacter::UnPossessed()
+{
+	Super::UnPossessed();
+	RemoveScope();
+}
+
+void AHomeworkCharacter::OnRep_Controller()
+{
+	Super::OnRep_Controller();
+	// Remote owners never run UnPossessed
+	if (!Controller)
+		RemoveScope();
+	InitializeForController();
+}
+
 void AHomeworkCharacter::GetLifetimeReplicatedProps(
 	TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
@@ -1105,10 +1444,29 @@ void AHomeworkCharacter::GetLifetimeReplicatedProps(
 	DOREPLIFETIME_CONDITION(AHomeworkCharacter, IsAiming, COND_None);
 	DOREPLIFETIME_CONDITION(AHomeworkCharacter, IsExplosion, COND_None);
 	DOREPLIFETIME_CONDITION(AHomeworkCharacter, ActiveWeapon, COND_None);
+	DOREPLIFETIME_CONDITION(AHomeworkCharacter, DeathPose, COND_None);
+	DOREPLIFETIME_CONDITION(AHomeworkCharacter, KnockdownCounter, COND_None);
+	DOREPLIFETIME_CONDITION(AHomeworkCharacter, ServerPrimaryWeapon, COND_OwnerOnly);
+}
+
+bool AHomeworkCharacter::CallRemoteFunction(UFunction* Function, void* Parameters,
+	FOutParmRec* OutParms, FFrame* Stack)
+{
+	FNetStatsRPCScope NetStatsScope(this, Function);
+	return Super::CallRemoteFunction(Function, Parameters, OutParms, Stack);
+}
+
+bool AHomeworkCharacter::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	if (AMultiFPSPlayerController::IsFilteredForSpectator(RealViewer, this))
+		return false;
+	return Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
 }
 
 void AHomeworkCharacter::BeginPlay()
 {
+	HITCH_SCOPE("AHomeworkCharacter::BeginPlay");
+	FHitchCapture::Get().AddEvent(TEXT("Spawn"), this);
 	Super::BeginPlay();
 
 	// ʼ
@@ -1118,25 +1476,26 @@ void AHomeworkCharacter::BeginPlay()
 	IsReloading = false;
 	IsAiming = false;
 	IsFirstTouch = true;
+	PendingTouchDelta = FVector2D::ZeroVector;
+	PendingTouchTime = 0.0;
+	TouchLatencyStartTime = 0.0;
 	CurGrenade = nullptr;
 	TestWeapon = FMath::RandRange(0, 2) > 0 ? EWeaponType::FPS : EWeaponType::Sniper;
-	ScreenControl = CreateWidget<UMyUserWidget>(GetWorld(), ScreenControlBPClass);
-	ScreenControl->SetCurrPawn(this);
-	ScreenControl->AddToViewport();
+	{
+		LLM_SCOPE_BYTAG(Homework_UI);
+		ScreenControl = CreateWidget<UMyUserWidget>(GetWorld(), ScreenControlBPClass);
+		ScreenControl->SetCurrPawn(this);
+		ScreenControl->AddToViewport();
+	}
 
 	OnTakePointDamage.AddDynamic(this, &AHomeworkCharacter::OnHit);
 
 	ClientArmsAnimBP = FPArmsMesh->GetAnimInstance();
 	ServerBodysAnimBP = GetMesh()->GetAnimInstance();
-	FPSPlayerController = Cast<AMultiFPSPlayerController>(GetController());
-	if (FPSPlayerController)
-	{
-		FPSPlayerController->CreatPlayerUI();
-	}
-	else
+	InitializeForController();
+	if (HasAuthority())
 	{
-		FLatentActionInfo ActionInfo(0, FMath::Rand(), TEXT("DelayGetControllerCallBack"), this);
-		UKismetSystemLibrary::Delay(this, 0.5, ActionInfo);
+		FMatchJournal::Get().Record(EMatchEventType::Spawn, this, nullptr, GetActorLocation());
 	}
 	StartWithKindofWeapon();
 }
@@ -1146,6 +1505,7 @@ void AHomeworkCharacter::FirePressed()
 	switch (ActiveWeapon)
 	{
 	case EWeaponType::FPS:
+	case EWeaponType::Shotgun:
 	{
 		FireWeaponPrimary();
 		break;
@@ -1165,6 +1525,7 @@ void AHomeworkCharacter::FireReleased()
 	switch (ActiveWeapon)
 	{
 	case EWeaponType::FPS:
+	case EWeaponType::Shotgun:
 	{
 		StopFireWeaponPrimary();
 		break;
@@ -1191,6 +1552,7 @@ void AHomeworkCharacter::Reload()
 		{
 		case EWeaponType::FPS:
 		case EWeaponType::Sniper:
+		case EWeaponType::Shotgun:
 		{
 			ReloadWeaponPrimary();
 			break;
@@ -43,6 +43,14 @@ private:
 	UPROPERTY(Replicated)
 	bool IsExplosion;
 
+	// 0 alive, 1 dead, the final death always falls down
+	UPROPERTY(ReplicatedUsing = OnRep_DeathPose)
+	uint8 DeathPose;
+
+	// Non-lethal grenade hits, each one staggers the character without killing it
+	UPROPERTY(ReplicatedUsing = OnRep_KnockdownCounter)
+	uint8 KnockdownCounter;
+
 	UPROPERTY(BlueprintReadOnly, Category = Character, meta = (AllowPrivateAccess = "true"))
 	UAnimInstance* ClientArmsAnimBP;
 
@@ -64,7 +72,12 @@ private:
 	UPROPERTY(EditAnywhere, meta = (AllowPrivateAccess = "true"))
 	EWeaponType TestWeapon;
 
-	UPROPERTY(meta = (AllowPrivateAccess = "true"))
+	// Server weapon blueprint of the shotgun. Empty or missing, the rifle blueprint is retuned as one
+	UPROPERTY(config)
+	FSoftClassPath ShotgunWeaponClass;
+
+	// Owner only, so the owning client can play the body montages it skips in the weapon counters
+	UPROPERTY(Replicated, meta = (AllowPrivateAccess = "true"))
 	AWeaponBaseServer* ServerPrimaryWeapon;
 
 	UPROPERTY(meta = (AllowPrivateAccess = "true"))
@@ -92,7 +105,7 @@ private:
 	TSubclassOf<UMyUserWidget> ScreenControlBPClass;
 
 public:
-	AHomeworkCharacter();
+	AHomeworkCharacter(const FObjectInitializer& ObjectInitializer);
 
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= Character)
@@ -105,6 +118,13 @@ public:
 	FVector Pre_Location;
 	bool IsFirstTouch;
 
+	// Touch drag collected since the last input pass, applied as a single look update
+	FVector2D PendingTouchDelta;
+	double PendingTouchTime;
+	// Touch to camera latency sample in flight
+	double TouchLatencyStartTime;
+	FRotator TouchLatencyRotation;
+
 	bool IsLockDirection;
 	FRotator CurYawRotation;
 
@@ -121,6 +141,13 @@ public:
 
 	AGrenade* CurGrenade;
 
+	// Owning client's view of the ammo, ahead of the server by the shots not yet acknowledged
+	int32 PredictedClipBullet;
+	int32 PredictedGunBullet;
+	uint16 NextShotSequence;
+	uint16 LastAckedShot;
+	uint16 PendingShotSequence;
+
 public:
 
 	/** Resets HMD orientation in VR. */
@@ -190,15 +217,38 @@ public:
 	void StopFireWeaponSniper();
 	void SniperLineTrace(FVector CameraLocation, FRotator CameraRotation, bool IsMoving);
 
+	// All pellets of a shot are traced as one batch, hits are folded per target
+	void ShotgunLineTrace(FVector CameraLocation, FRotator CameraRotation, bool IsMoving);
+
+	// Game thread end of a shot UHitResolver traced: damage per target summed, decals for the rest.
+	// The decal arrays are the resolver's frame buffers, reset here and reused by every shot
+	void ApplyResolvedShot(FVector Start, const FVector& Forward, uint32 ShotId, TArrayView<FHitResult> Hits,
+		TArrayView<const float> Damages, TArray<FVector_NetQuantize>& DecalLocations,
+		TArray<FVector_NetQuantizeNormal>& DecalNormals);
+
 	// ʱ
 	void AutoMaticFire();
 
 	// 
 	void ResetRecoil();
 
+	// Spends one predicted bullet and assigns the shot its sequence number
+	bool PredictShot();
+	int32 GetUnackedShots() const;
+
 	void DamagePlayer(AActor* DamageActor, AActor* DamageCauser, FVector& HitFromDirection, FHitResult& HitInfo);
+	void ApplyWeaponDamage(AActor* DamageActor, AActor* DamageCauser, float Damage, FVector& HitFromDirection,
+		FHitResult& HitInfo);
 
-	void Dead(AActor* DamageCauser, bool IsDown = false);
+	// Decal of a bullet hitting the world, the server pushes props through UPropPhysicsManager
+	void SpawnBulletImpact(const FVector& Location, const FVector& Normal);
+	void PushProp(const FHitResult& HitResult, const FVector& ForwordVector);
+
+	void Dead(AActor* DamageCauser);
+	// Server, the dead player follows its killer on the low bandwidth feed
+	void StartSpectating(AActor* Killer);
+	void Knockdown();
+	void ClearWeapons();
 
 	UFUNCTION()
 	void OnHit(AActor* DamagedActor, float Damage, class AController* InstigatedBy, 
@@ -214,15 +264,29 @@ public:
 	UFUNCTION()
 	void DelayPlayGrenadeExplosionCallBack();
 
-	UFUNCTION()
-	void DelayGetControllerCallBack();
+	// Binds the player controller and builds its HUD, from whichever of BeginPlay, PossessedBy,
+	// OnRep_Controller or AcknowledgePossession comes last
+	void InitializeForController();
+
+	/** Applies the touch drag collected this frame, from the controller's input pass before UpdateRotation. */
+	void ApplyPendingTouchLook();
+	/** Ends the touch to camera sample once the control rotation has moved. */
+	void UpdateTouchLatency();
 
 	void GetLifetimeReplicatedProps(
 		TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
+	virtual bool CallRemoteFunction(UFunction* Function, void* Parameters,
+		FOutParmRec* OutParms, FFrame* Stack) override;
+
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
 protected:
 	// APawn interface
 	virtual void BeginPlay() override;
+	virtual void PossessedBy(AController* NewController) override;
+	virtual void UnPossessed() override;
+	virtual void OnRep_Controller() override;
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 	// End of APawn interface
 
@@ -243,29 +307,14 @@ public:
 public:
 #pragma region Networking
 	UFUNCTION(server, Reliable, WithValidation)
-	void ServerLowSpeedWalkAction();
-	void ServerLowSpeedWalkAction_Implementation();
-	bool ServerLowSpeedWalkAction_Validate();
+	void ServerFireRifleWeapon(FVector CameraLocation, FRotator CameraRotation, bool IsMoving, uint16 ShotSequence);
+	void ServerFireRifleWeapon_Implementation(FVector CameraLocation, FRotator CameraRotation, bool IsMoving, uint16 ShotSequence);
+	bool ServerFireRifleWeapon_Validate(FVector CameraLocation, FRotator CameraRotation, bool IsMoving, uint16 ShotSequence);
 
 	UFUNCTION(server, Reliable, WithValidation)
-	void ServerNormalSpeedWalkAction();
-	void ServerNormalSpeedWalkAction_Implementation();
-	bool ServerNormalSpeedWalkAction_Validate();
-
-	UFUNCTION(server, Reliable, WithValidation)
-	void ServerHighSpeedRunAction();
-	void ServerHighSpeedRunAction_Implementation();
-	bool ServerHighSpeedRunAction_Validate();
-
-	UFUNCTION(server, Reliable, WithValidation)
-	void ServerFireRifleWeapon(FVector CameraLocation, FRotator CameraRotation, bool IsMoving);
-	void ServerFireRifleWeapon_Implementation(FVector CameraLocation, FRotator CameraRotation, bool IsMoving);
-	bool ServerFireRifleWeapon_Validate(FVector CameraLocation, FRotator CameraRotation, bool IsMoving);
-
-	UFUNCTION(server, Reliable, WithValidation)
-	void ServerFireSniperWeapon(FVector CameraLocation, FRotator CameraRotation, bool IsMoving);
-	void ServerFireSniperWeapon_Implementation(FVector CameraLocation, FRotator CameraRotation, bool IsMoving);
-	bool ServerFireSniperWeapon_Validate(FVector CameraLocation, FRotator CameraRotation, bool IsMoving);
+	void ServerFireSniperWeapon(FVector CameraLocation, FRotator CameraRotation, bool IsMoving, uint16 ShotSequence);
+	void ServerFireSniperWeapon_Implementation(FVector CameraLocation, FRotator CameraRotation, bool IsMoving, uint16 ShotSequence);
+	bool ServerFireSniperWeapon_Validate(FVector CameraLocation, FRotator CameraRotation, bool IsMoving, uint16 ShotSequence);
 
 	UFUNCTION(server, Reliable, WithValidation)
 	void ServerReload();
@@ -287,30 +336,39 @@ public:
 	void ServerGrenadeExplode_Implementation();
 	bool ServerGrenadeExplode_Validate();
 
-	UFUNCTION(NetMulticast, Reliable, WithValidation)
-	void MultiShooting();
-	void MultiShooting_Implementation();
-	bool MultiShooting_Validate();
+	UFUNCTION()
+	void OnRep_DeathPose();
+
+	UFUNCTION()
+	void OnRep_KnockdownCounter();
 
+	void PlayOwnBodyMontage(UAnimMontage* Montage);
+
+	// Every machine solves the same grenade path from these and the seed
 	UFUNCTION(NetMulticast, Reliable, WithValidation)
-	void MultiReload();
-	void MultiReload_Implementation();
-	bool MultiReload_Validate();
+	void MultiGrenadeExplode(const FRotator SpawnRotation, const FVector_NetQuantize SpawnLocation, int32 Seed);
+	void MultiGrenadeExplode_Implementation(const FRotator SpawnRotation, const FVector_NetQuantize SpawnLocation, int32 Seed);
+	bool MultiGrenadeExplode_Validate(const FRotator SpawnRotation, const FVector_NetQuantize SpawnLocation, int32 Seed);
 
+	// Sent only when the server's grenade hits something the local solves ignore
 	UFUNCTION(NetMulticast, Reliable, WithValidation)
-	void MultiDead(bool IsDown);
-	void MultiDead_Implementation(bool IsDown);
-	bool MultiDead_Validate(bool IsDown);
+	void MultiGrenadeCorrect(FVector_NetQuantize Location, FVector_NetQuantize10 Velocity, float FlightTime);
+	void MultiGrenadeCorrect_Implementation(FVector_NetQuantize Location, FVector_NetQuantize10 Velocity, float FlightTime);
+	bool MultiGrenadeCorrect_Validate(FVector_NetQuantize Location, FVector_NetQuantize10 Velocity, float FlightTime);
 
+	// Quantized hit data instead of a full FHitResult, this is also what replays record
 	UFUNCTION(NetMulticast, Reliable, WithValidation)
-	void MultiGrenadeExplode(const FRotator SpawnRotation, const FVector SpawnLocation);
-	void MultiGrenadeExplode_Implementation(const FRotator SpawnRotation, const FVector SpawnLocation);
-	bool MultiGrenadeExplode_Validate(const FRotator SpawnRotation, const FVector SpawnLocation);
+	void MultiSpawnBulletDecal(FVector_NetQuantize Location, FVector_NetQuantizeNormal Normal);
+	void MultiSpawnBulletDecal_Implementation(FVector_NetQuantize Location, FVector_NetQuantizeNormal Normal);
+	bool MultiSpawnBulletDecal_Validate(FVector_NetQuantize Location, FVector_NetQuantizeNormal Normal);
 
+	// One message for every pellet of a shot that hit the world
 	UFUNCTION(NetMulticast, Reliable, WithValidation)
-	void MultiSpawnBulletDecal(const FHitResult& HitInfo, FRotator Rotation, FVector ForwordVector);
-	void MultiSpawnBulletDecal_Implementation(const FHitResult& HitInfo, FRotator Rotation, FVector ForwordVector);
-	bool MultiSpawnBulletDecal_Validate(const FHitResult& HitInfo, FRotator Rotation, FVector ForwordVector);
+	void MultiSpawnPelletDecals(const TArray<FVector_NetQuantize>& Locations, const TArray<FVector_NetQuantizeNormal>& Normals);
+	void MultiSpawnPelletDecals_Implementation(const TArray<FVector_NetQuantize>& Locations,
+		const TArray<FVector_NetQuantizeNormal>& Normals);
+	bool MultiSpawnPelletDecals_Validate(const TArray<FVector_NetQuantize>& Locations,
+		const TArray<FVector_NetQuantizeNormal>& Normals);
 
 	UFUNCTION(Client, Reliable)
 	void ClientEquipFPArmsPrimary();
@@ -332,9 +390,15 @@ public:
 	void ClientUpdateBulletUI(int32 ClipCurrBullet, int32 GunCurrBullet);
 	void ClientUpdateBulletUI_Implementation(int32 ClipCurrBullet, int32 GunCurrBullet);
 
+	// Unreliable, every ack carries the absolute counts so the next one repairs a lost one
+	UFUNCTION(Client, Unreliable)
+	void ClientAckShot(uint16 ShotSequence, bool Accepted, int32 ClipCurrBullet, int32 GunCurrBullet);
+	void ClientAckShot_Implementation(uint16 ShotSequence, bool Accepted, int32 ClipCurrBullet, int32 GunCurrBullet);
+
+	// ShotId is the shot trace of the hit, 0 if untraced
 	UFUNCTION(Client, Reliable)
-	void ClientUpdateHPUI(float CurrHP);
-	void ClientUpdateHPUI_Implementation(float CurrHP);
+	void ClientUpdateHPUI(float CurrHP, uint32 ShotId);
+	void ClientUpdateHPUI_Implementation(float CurrHP, uint32 ShotId);
 
 	UFUNCTION(Client, Reliable)
 	void ClientRecoil();
@@ -344,6 +408,13 @@ public:
 	void ClientAiming();
 	void ClientAiming_Implementation();
 
+	// Scope widget is created on first use and then only shown or collapsed
+	void SetScopeVisible(bool bVisible);
+	// Takes the scope out of the viewport when this pawn stops being the local player's
+	void RemoveScope();
+	TSubclassOf<UUserWidget> GetScopeClass() const { return SniperScopeBPClass; }
+	UUserWidget* GetScopeWidget() const { return WidgetScope; }
+
 	UFUNCTION(Client, Reliable)
 	void ClientClearWeapon();
 	void ClientClearWeapon_Implementation();
@@ -3,8 +3,26 @@
 #include "HomeworkGameMode.h"
 #include "HomeworkCharacter.h"
 #include "public/MultiFPSPlayerController.h"
+#include "public/DeathMatchGameState.h"
+#include "public/MatchJournal.h"
+#include "public/AICharacter.h"
+#include "public/Grenade.h"
+#include "public/WeaponBaseServer.h"
+#include "Engine/GameInstance.h"
+#include "EngineUtils.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
 #include "UObject/ConstructorHelpers.h"
 
+// Off until the recording cost on a dedicated server has been measured against the 2% budget
+static TAutoConsoleVariable<int32> CVarRecordMatchReplay(
+	TEXT("Homework.Replay.Record"),
+	0,
+	TEXT("Record every match into a replay. 0: off, 1: dedicated server only, 2: any server."));
+
 AHomeworkGameMode::AHomeworkGameMode()
 {
 	// set default pawn class to our Blueprinted character
@@ -19,4 +37,87 @@ AHomeworkGameMode::AHomeworkGameMode()
 	{
 		PlayerControllerClass = PlayerControllerBPClass.Class;
 	}
+	GameStateClass = ADeathMatchGameState::StaticClass();
+	RecordingStartTime = 0.0;
+}
+
+void AHomeworkGameMode::StartPlay()
+{
+	Super::StartPlay();
+	StartMatchRecording();
+}
+
+void AHomeworkGameMode::PostLogin(APlayerController* NewPlayer)
+{
+	Super::PostLogin(NewPlayer);
+	if (ADeathMatchGameState* DeathMatchState = GetGameState<ADeathMatchGameState>())
+	{
+		DeathMatchState->RegisterPlayer(NewPlayer);
+	}
+	// Joined with ?SpectatorOnly=1, e.g. watching a LAN match
+	AMultiFPSPlayerController* PlayerController = Cast<AMultiFPSPlayerController>(NewPlayer);
+	if (PlayerController && PlayerController->PlayerState && PlayerController->PlayerState->IsOnlyASpectator())
+	{
+		PlayerController->StartLowBandwidthSpectating(nullptr);
+	}
+}
+
+void AHomeworkGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// One journal per match, the next event opens a new file
+	FMatchJournal::Get().Close();
+	StopMatchRecording();
+	Super::EndPlay(EndPlayReason);
+}
+
+bool AHomeworkGameMode::IsReplayRelevant(const AActor* Actor)
+{
+	return Actor->IsA<AHomeworkCharacter>() || Actor->IsA<AAICharacter>()
+		|| Actor->IsA<AWeaponBaseServer>() || Actor->IsA<AGrenade>() || Actor->IsA<AInfo>();
+}
+
+void AHomeworkGameMode::StartMatchRecording()
+{
+	const int32 RecordMode = CVarRecordMatchReplay.GetValueOnGameThread();
+	const ENetMode NetMode = GetNetMode();
+	if (RecordMode == 0 || NetMode == NM_Standalone || NetMode == NM_Client
+		|| (RecordMode == 1 && NetMode != NM_DedicatedServer))
+		return;
+	UGameInstance* GameInstance = GetGameInstance();
+	if (!GameInstance)
+		return;
+
+	// Everything else (props, level decoration, controllers) is left out of the replay
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		It->bRelevantForNetworkReplays = IsReplayRelevant(*It);
+	}
+	ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(
+		FOnActorSpawned::FDelegate::CreateUObject(this, &AHomeworkGameMode::OnActorSpawned));
+
+	ReplayName = FString::Printf(TEXT("Match-%s"), *FDateTime::Now().ToString());
+	GameInstance->StartRecordingReplay(ReplayName, GetWorld()->GetMapName());
+	RecordingStartTime = FPlatformTime::Seconds();
+}
+
+void AHomeworkGameMode::StopMatchRecording()
+{
+	if (ReplayName.IsEmpty())
+		return;
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	if (UGameInstance* GameInstance = GetGameInstance())
+	{
+		GameInstance->StopRecordingReplay();
+	}
+
+	const int64 ReplaySize = IFileManager::Get().FileSize(
+		*(FPaths::ProjectSavedDir() / TEXT("Demos") / (ReplayName + TEXT(".replay"))));
+	UE_LOG(LogTemp, Display, TEXT("Recorded %s: %.0f s, %lld KB"), *ReplayName,
+		FPlatformTime::Seconds() - RecordingStartTime, ReplaySize / 1024);
+	ReplayName.Empty();
+}
+
+void AHomeworkGameMode::OnActorSpawned(AActor* Actor)
+{
+	Actor->bRelevantForNetworkReplays = IsReplayRelevant(Actor);
 }
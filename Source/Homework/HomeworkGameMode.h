@@ -13,6 +13,22 @@ class AHomeworkGameMode : public AGameModeBase
 
 public:
 	AHomeworkGameMode();
+
+	virtual void StartPlay() override;
+	virtual void PostLogin(APlayerController* NewPlayer) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Replays only keep characters, AI, weapons, grenades and the game/player state infos
+	static bool IsReplayRelevant(const AActor* Actor);
+
+protected:
+	void StartMatchRecording();
+	void StopMatchRecording();
+	void OnActorSpawned(AActor* Actor);
+
+	FDelegateHandle ActorSpawnedHandle;
+	FString ReplayName;
+	double RecordingStartTime;
 };
 
 
@@ -7,14 +7,25 @@
 #include "Components/CapsuleComponent.h"
 #include "AICharacterController.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "HomeworkMovementComponent.h"
+#include "NetStatsCollector.h"
+#include "DeathMatchGameState.h"
+#include "MatchJournal.h"
+#include "NetUpdateManager.h"
+#include "MemoryTags.h"
+#include "HitchCapture.h"
+#include "ShotTrace.h"
+#include "Net/UnrealNetwork.h"
 
 const TMap<EWeaponType, FName> BodyLocation = {
 	{EWeaponType::FPS, TEXT("Weapon_FPS")},
 	{EWeaponType::Sniper, TEXT("Weapon_Sniper")}
 };
 // Sets default values
-AAICharacter::AAICharacter()
+AAICharacter::AAICharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UHomeworkMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
+	LLM_SCOPE_BYTAG(Homework_AI);
  	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
@@ -27,6 +38,7 @@ AAICharacter::AAICharacter()
 
 	GetMesh()->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
 	GetMesh()->SetCollisionObjectType(ECollisionChannel::ECC_Pawn);
+	DeadCounter = 0;
 }
 
 AWeaponBaseServer* AAICharacter::GetCurrentServerWeapon()
@@ -49,6 +61,9 @@ void AAICharacter::EquipPrimary(AWeaponBaseServer* WeaponBaseServer)
 // Called when the game starts or when spawned
 void AAICharacter::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(Homework_AI);
+	HITCH_SCOPE("AAICharacter::BeginPlay");
+	FHitchCapture::Get().AddEvent(TEXT("Spawn"), this);
 	Super::BeginPlay();
 	HP = 100;
 	ActiveWeapon = FMath::RandRange(0, 1) == 0 ? EWeaponType::FPS : EWeaponType::Sniper;
@@ -56,9 +71,23 @@ void AAICharacter::BeginPlay()
 	ServerBodysAnimBP = GetMesh()->GetAnimInstance();
 
 	AIControllerClass = AAICharacterController::StaticClass();
+	if (HasAuthority())
+	{
+		FMatchJournal::Get().Record(EMatchEventType::Spawn, this, nullptr, GetActorLocation());
+	}
 	StartWithKindofWeapon();
 }
 
+void AAICharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ADeathMatchGameState* DeathMatchState = GetWorld()->GetGameState<ADeathMatchGameState>();
+	if (DeathMatchState && HasAuthority())
+	{
+		DeathMatchState->RemovePlayer(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
 void AAICharacter::StartWithKindofWeapon()
 {
 	if (HasAuthority())
@@ -69,6 +98,9 @@ void AAICharacter::StartWithKindofWeapon()
 
 void AAICharacter::PurchaseWeapon(EWeaponType WeaponType)
 {
+	LLM_SCOPE_BYTAG(Homework_Weapons);
+	HITCH_SCOPE("AAICharacter::PurchaseWeapon");
+	FHitchCapture::Get().AddEvent(TEXT("WeaponLoad"), this);
 	FActorSpawnParameters SapwnInfo;
 	SapwnInfo.Owner = this;
 	SapwnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
@@ -82,6 +114,8 @@ void AAICharacter::PurchaseWeapon(EWeaponType WeaponType)
 			GetWorld()->SpawnActor<AWeaponBaseServer>(BlueprintVar, GetActorTransform(), SapwnInfo);
 		ServerWeapon->EquipWeapon(false);
 		EquipPrimary(ServerWeapon);
+		FMatchJournal::Get().Record(EMatchEventType::Pickup, this, ServerWeapon, GetActorLocation(),
+			0.0f, uint8(WeaponType));
 		break;
 	}
 	case EWeaponType::Sniper:
@@ -92,6 +126,8 @@ void AAICharacter::PurchaseWeapon(EWeaponType WeaponType)
 			GetWorld()->SpawnActor<AWeaponBaseServer>(BlueprintVar, GetActorTransform(), SapwnInfo);
 		ServerWeapon->EquipWeapon();
 		EquipPrimary(ServerWeapon);
+		FMatchJournal::Get().Record(EMatchEventType::Pickup, this, ServerWeapon, GetActorLocation(),
+			0.0f, uint8(WeaponType));
 		break;
 	}
 	default:
@@ -149,6 +185,8 @@ void AAICharacter::DamagePlayer(AActor* DamageActor, AActor* DamageCauser, FVect
 			Damage = 20;
 	}
 	// ײ۲ģʽ,˱˷֪ͨ
+	FMatchJournal::Get().Record(EMatchEventType::Damage, DamageCauser, DamageActor, HitInfo.Location, Damage,
+		HitInfo.PhysMaterial.IsValid() ? uint8(HitInfo.PhysMaterial->SurfaceType) : 0);
 	UGameplayStatics::ApplyPointDamage(DamageActor, Damage, HitFromDirection,
 		HitInfo, GetController(), DamageCauser, UDamageType::StaticClass());
 	// ԼʱĻصOnHit
@@ -156,11 +194,25 @@ void AAICharacter::DamagePlayer(AActor* DamageActor, AActor* DamageCauser, FVect
 
 void AAICharacter::Dead(AActor* DamageCauser)
 {
+	// A grenade that does not kill comes through here too, only the first call is recorded
+	TOptional<FHitchScope> HitchScope;
+	if (DeadCounter == 0)
+	{
+		HitchScope.Emplace(TEXT("AAICharacter::Dead"));
+		FHitchCapture::Get().AddEvent(TEXT("Death"), this);
+	}
+	ADeathMatchGameState* DeathMatchState = GetWorld()->GetGameState<ADeathMatchGameState>();
+	if (DeathMatchState && HasAuthority())
+	{
+		if (DamageCauser)
+			DeathMatchState->AddScore(DamageCauser, 1);
+	}
 	if (DamageCauser)
 	{
 		DeathMatch(DamageCauser);
 	}
-	MultiDead();
+	++DeadCounter;
+	PlayDead();
 }
 
 void AAICharacter::DelayPlayDeadCallBack()
@@ -171,15 +223,21 @@ void AAICharacter::DelayPlayDeadCallBack()
 
 void AAICharacter::OnHit(AActor* DamagedActor, float Damage, class AController* InstigatedBy, FVector HitLocation, class UPrimitiveComponent* FHitComponent, FName BoneName, FVector ShotFromDirection, const class UDamageType* DamageType, AActor* DamageCauser)
 {
+	HITCH_SCOPE("AAICharacter::OnHit");
 	if (HP == 0)
 		return;
+	UNetUpdateManager::NotifyCombat(this);
+	UNetUpdateManager::NotifyCombat(DamageCauser);
 	HP = (HP > Damage) ? HP - Damage : 0;
+	FShotTrace::Get().Record(this, FShotTrace::Get().GetCurrentShot(), EShotStage::ServerHit);
+	FMatchJournal::Get().Record(EMatchEventType::Hit, DamageCauser, this, HitLocation, HP);
 	AGrenade* DamageSrc = Cast<AGrenade>(DamageCauser);
 	if (HP == 0)
 	{
 		// ߼
 		if (DamageSrc)
 			DamageCauser = DamageSrc->GrenadeOwner;
+		FMatchJournal::Get().Record(EMatchEventType::Death, DamageCauser, this, GetActorLocation());
 		Dead(DamageCauser);
 	}
 	else
@@ -191,7 +249,11 @@ void AAICharacter::OnHit(AActor* DamagedActor, float Damage, class AController*
 
 void AAICharacter::FireWeaponPrimary()
 {
-	MultiShooting();
+	UNetUpdateManager::NotifyCombat(this);
+	if (ServerPrimaryWeapon)
+	{
+		ServerPrimaryWeapon->NotifyShot();
+	}
 }
 
 // Called every frame
@@ -208,35 +270,40 @@ void AAICharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCompone
 
 }
 
-void AAICharacter::MultiShooting_Implementation()
+bool AAICharacter::CallRemoteFunction(UFunction* Function, void* Parameters,
+	FOutParmRec* OutParms, FFrame* Stack)
 {
-	if (ServerPrimaryWeapon)
-	{
-		// ಥЧ
-		ServerPrimaryWeapon->MultiShootingEffect();
-		// ಥ嶯
-		if (ServerBodysAnimBP)
-		{
-			ServerBodysAnimBP->Montage_Play(ServerPrimaryWeapon->ServerTPBodysShootAnimMontage);
-		}
+	FNetStatsRPCScope NetStatsScope(this, Function);
+	return Super::CallRemoteFunction(Function, Parameters, OutParms, Stack);
+}
 
-		//RifleLineTrace(CameraLocation, CameraRotation, IsMoving);
+bool AAICharacter::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	if (AMultiFPSPlayerController::IsFilteredForSpectator(RealViewer, this))
+		return false;
+	return Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
+}
 
-	}
+void AAICharacter::GetLifetimeReplicatedProps(
+	TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME_CONDITION(AAICharacter, DeadCounter, COND_None);
 }
 
-bool AAICharacter::MultiShooting_Validate()
+void AAICharacter::OnRep_DeadCounter()
 {
-	return true;
+	if (HasActorBegunPlay())
+		PlayDead();
 }
 
-void AAICharacter::MultiDead_Implementation()
+void AAICharacter::PlayDead()
 {
 	if (ServerBodysAnimBP)
 	{
 		ServerBodysAnimBP->Montage_Play(ServerTPBodysDeadAnimMontage);
 	}
-	if (HP == 0)
+	if (HP == 0 && HasAuthority())
 	{
 		FLatentActionInfo ActionInfo(0, FMath::Rand(), TEXT("DelayPlayDeadCallBack"), this);
 		UKismetSystemLibrary::Delay(this,
@@ -244,8 +311,3 @@ void AAICharacter::MultiDead_Implementation()
 	}
 }
 
-bool AAICharacter::MultiDead_Validate()
-{
-	return true;
-}
-
@@ -4,12 +4,19 @@
 #include "AICharacterController.h"
 #include "NavigationSystem.h"
 #include "Kismet/GameplayStatics.h"
+#include "MemoryTags.h"
+#include "DeathMatchGameState.h"
 
 void AAICharacterController::OnPossess(class APawn* InPawn)
 {
-	UE_LOG(LogTemp, Warning, TEXT("OnPossess"));
+	LLM_SCOPE_BYTAG(Homework_AI);
 	Super::OnPossess(InPawn);
 	AICharacter = Cast<AAICharacter>(InPawn);
+	ADeathMatchGameState* DeathMatchState = GetWorld()->GetGameState<ADeathMatchGameState>();
+	if (DeathMatchState && InPawn)
+	{
+		DeathMatchState->RegisterPlayer(InPawn);
+	}
 	SearchNewPoint();
 }
 
@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AllocationCounter.h"
+#include "HAL/MemoryBase.h"
+#include "Misc/CommandLine.h"
+#include "Misc/CoreDelegates.h"
+#include "Templates/Atomic.h"
+
+#if !UE_BUILD_SHIPPING
+namespace
+{
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+		explicit FCountingMalloc(FMalloc* InInner)
+			: Inner(InInner)
+		{
+		}
+
+		virtual void* Malloc(SIZE_T Size, uint32 Alignment) override
+		{
+			Record(Size);
+			return Inner->Malloc(Size, Alignment);
+		}
+
+		virtual void* TryMalloc(SIZE_T Size, uint32 Alignment) override
+		{
+			Record(Size);
+			return Inner->TryMalloc(Size, Alignment);
+		}
+
+		virtual void* Realloc(void* Ptr, SIZE_T NewSize, uint32 Alignment) override
+		{
+			RecordRealloc(Ptr, NewSize);
+			return Inner->Realloc(Ptr, NewSize, Alignment);
+		}
+
+		virtual void* TryRealloc(void* Ptr, SIZE_T NewSize, uint32 Alignment) override
+		{
+			RecordRealloc(Ptr, NewSize);
+			return Inner->TryRealloc(Ptr, NewSize, Alignment);
+		}
+
+		virtual void Free(void* Ptr) override { Inner->Free(Ptr); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+		virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual void InitializeStatsMetadata() override { Inner->InitializeStatsMetadata(); }
+		virtual void UpdateStats() override { Inner->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+		virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+		virtual void OnMallocInitialized() override { Inner->OnMallocInitialized(); }
+		virtual void OnPreFork() override { Inner->OnPreFork(); }
+		virtual void OnPostFork() override { Inner->OnPostFork(); }
+
+		// Scopes are opened on the game thread, while one is open every thread is counted
+		TAtomic<int32> NumScopes{ 0 };
+		TAtomic<int32> Allocations{ 0 };
+		TAtomic<int64> Bytes{ 0 };
+
+	private:
+		void Record(SIZE_T Size)
+		{
+			if (NumScopes.Load(EMemoryOrder::Relaxed) > 0)
+			{
+				++Allocations;
+				Bytes += Size;
+			}
+		}
+
+		void RecordRealloc(void* Ptr, SIZE_T NewSize)
+		{
+			SIZE_T OldSize = 0;
+			if (NewSize > 0 && (!Ptr || !Inner->GetAllocationSize(Ptr, OldSize) || NewSize > OldSize))
+				Record(NewSize);
+		}
+
+		FMalloc* Inner;
+	};
+
+	// Never destroyed, memory allocated through it can be freed at any point after
+	FCountingMalloc* CountingMalloc = nullptr;
+
+	void InstallCountingMalloc()
+	{
+		// Still single threaded here, every allocation from now on goes through the same wrapper
+		if (!CountingMalloc && FParse::Param(FCommandLine::Get(), TEXT("homeworkalloccount")))
+		{
+			CountingMalloc = new FCountingMalloc(GMalloc);
+			GMalloc = CountingMalloc;
+		}
+	}
+
+	struct FCountingMallocInstaller
+	{
+		FCountingMallocInstaller()
+		{
+			FCoreDelegates::GetPreMainInitDelegate().AddStatic(&InstallCountingMalloc);
+		}
+	} CountingMallocInstaller;
+}
+
+bool FScopedAllocationCounter::IsInstalled()
+{
+	return CountingMalloc != nullptr;
+}
+
+FScopedAllocationCounter::FScopedAllocationCounter()
+	: StartAllocations(0)
+	, StartBytes(0)
+{
+	check(IsInGameThread());
+	if (CountingMalloc)
+	{
+		StartAllocations = CountingMalloc->Allocations.Load();
+		StartBytes = CountingMalloc->Bytes.Load();
+		++CountingMalloc->NumScopes;
+	}
+}
+
+FScopedAllocationCounter::~FScopedAllocationCounter()
+{
+	if (CountingMalloc)
+		--CountingMalloc->NumScopes;
+}
+
+int32 FScopedAllocationCounter::GetAllocations() const
+{
+	return CountingMalloc ? CountingMalloc->Allocations.Load() - StartAllocations : 0;
+}
+
+int64 FScopedAllocationCounter::GetBytes() const
+{
+	return CountingMalloc ? CountingMalloc->Bytes.Load() - StartBytes : 0;
+}
+
+FScopedAllocationCounterPause::FScopedAllocationCounterPause()
+	: PausedScopes(0)
+{
+	check(IsInGameThread());
+	if (CountingMalloc)
+	{
+		PausedScopes = CountingMalloc->NumScopes.Exchange(0);
+	}
+}
+
+FScopedAllocationCounterPause::~FScopedAllocationCounterPause()
+{
+	if (CountingMalloc)
+		CountingMalloc->NumScopes += PausedScopes;
+}
+#endif
@@ -0,0 +1,187 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DeathMatchGameState.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerState.h"
+#include "Net/UnrealNetwork.h"
+
+void FDeathMatchNameItem::PostReplicatedAdd(const FDeathMatchNameArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+		InArraySerializer.Owner->OnNameReplicated(*this);
+}
+
+void FDeathMatchScoreItem::PostReplicatedAdd(const FDeathMatchScoreArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+		InArraySerializer.Owner->OnScoreReplicated(*this);
+}
+
+void FDeathMatchScoreItem::PostReplicatedChange(const FDeathMatchScoreArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+		InArraySerializer.Owner->OnScoreReplicated(*this);
+}
+
+void FDeathMatchScoreItem::PreReplicatedRemove(const FDeathMatchScoreArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+		InArraySerializer.Owner->OnScoreRemoved(*this);
+}
+
+ADeathMatchGameState::ADeathMatchGameState()
+{
+	PlayerNames.Owner = this;
+	PlayerScores.Owner = this;
+	NextPlayerId = 1;
+}
+
+static const APlayerState* FindPlayerState(const AActor* Player, const AController*& OutController)
+{
+	const APawn* Pawn = Cast<APawn>(Player);
+	OutController = Pawn ? Pawn->GetController() : Cast<AController>(Player);
+	return Pawn && Pawn->GetPlayerState() ? Pawn->GetPlayerState()
+		: OutController ? OutController->PlayerState : nullptr;
+}
+
+bool ADeathMatchGameState::FindPlayerId(const AActor* Player, uint16& OutId) const
+{
+	const AController* Controller;
+	const APlayerState* PlayerState = FindPlayerState(Player, Controller);
+	const uint16* Id = PlayerState ? IdByName.Find(FName(*PlayerState->GetPlayerName())) : IdByActor.Find(Player);
+	if (!Id)
+		return false;
+	OutId = *Id;
+	return true;
+}
+
+uint16 ADeathMatchGameState::RegisterPlayer(AActor* Player)
+{
+	check(HasAuthority());
+	// Players keep their name across respawns
+	const AController* Controller;
+	const APlayerState* PlayerState = FindPlayerState(Player, Controller);
+	FName Name;
+	if (PlayerState)
+	{
+		Name = FName(*PlayerState->GetPlayerName());
+		if (const uint16* Id = IdByName.Find(Name))
+			return *Id;
+	}
+	else
+	{
+		if (const uint16* Id = IdByActor.Find(Player))
+			return *Id;
+		// Named after the controller, respawned AI get a new row and the old one goes with its pawn
+		Name = Controller ? Controller->GetFName() : Player->GetFName();
+	}
+
+	const uint16 Id = NextPlayerId++;
+	if (!PlayerState)
+		IdByActor.Add(Player, Id);
+	IdByName.Add(Name, Id);
+	NameById.Add(Id, Name);
+
+	FDeathMatchNameItem& NameItem = PlayerNames.Items.AddDefaulted_GetRef();
+	NameItem.PlayerId = Id;
+	NameItem.PlayerName = Name;
+	PlayerNames.MarkItemDirty(NameItem);
+
+	FDeathMatchScoreItem& ScoreItem = PlayerScores.Items.AddDefaulted_GetRef();
+	ScoreItem.PlayerId = Id;
+	ScoreIndexById.Add(Id, PlayerScores.Items.Num() - 1);
+	PlayerScores.MarkItemDirty(ScoreItem);
+
+	Scoreboard.AddPlayer(Name);
+	return Id;
+}
+
+void ADeathMatchGameState::AddScore(AActor* Player, int32 Delta)
+{
+	if (!HasAuthority() || !Player)
+		return;
+	const uint16 Id = RegisterPlayer(Player);
+	FDeathMatchScoreItem& ScoreItem = PlayerScores.Items[ScoreIndexById.FindChecked(Id)];
+	ScoreItem.PlayerScore += Delta;
+	PlayerScores.MarkItemDirty(ScoreItem);
+
+	Scoreboard.SetScore(NameById.FindChecked(Id), ScoreItem.PlayerScore);
+	OnScoreboardChanged.Broadcast();
+}
+
+void ADeathMatchGameState::RemovePlayer(AActor* Player)
+{
+	uint16 Id;
+	if (!HasAuthority() || !IdByActor.RemoveAndCopyValue(Player, Id))
+		return;
+	FName Name;
+	if (NameById.RemoveAndCopyValue(Id, Name))
+	{
+		IdByName.Remove(Name);
+		Scoreboard.RemovePlayer(Name);
+	}
+
+	PlayerNames.Items.RemoveAll([Id](const FDeathMatchNameItem& Item) { return Item.PlayerId == Id; });
+	PlayerNames.MarkArrayDirty();
+	PlayerScores.Items.RemoveAll([Id](const FDeathMatchScoreItem& Item) { return Item.PlayerId == Id; });
+	PlayerScores.MarkArrayDirty();
+	ScoreIndexById.Reset();
+	for (int32 i = 0; i < PlayerScores.Items.Num(); ++i)
+	{
+		ScoreIndexById.Add(PlayerScores.Items[i].PlayerId, i);
+	}
+	OnScoreboardChanged.Broadcast();
+}
+
+bool ADeathMatchGameState::GetEntryAtRank(int32 Rank, FDeathMatchPlayerData& OutData) const
+{
+	if (!Scoreboard.GetRanked().IsValidIndex(Rank))
+		return false;
+	OutData = Scoreboard.GetRanked()[Rank];
+	return true;
+}
+
+void ADeathMatchGameState::OnNameReplicated(const FDeathMatchNameItem& Item)
+{
+	NameById.Add(Item.PlayerId, Item.PlayerName);
+	IdByName.Add(Item.PlayerName, Item.PlayerId);
+	// The score row may have arrived first
+	for (const FDeathMatchScoreItem& ScoreItem : PlayerScores.Items)
+	{
+		if (ScoreItem.PlayerId == Item.PlayerId)
+		{
+			OnScoreReplicated(ScoreItem);
+			return;
+		}
+	}
+}
+
+void ADeathMatchGameState::OnScoreReplicated(const FDeathMatchScoreItem& Item)
+{
+	const FName* Name = NameById.Find(Item.PlayerId);
+	if (!Name)
+		return;
+	Scoreboard.SetScore(*Name, Item.PlayerScore);
+	OnScoreboardChanged.Broadcast();
+}
+
+void ADeathMatchGameState::OnScoreRemoved(const FDeathMatchScoreItem& Item)
+{
+	FName Name;
+	if (NameById.RemoveAndCopyValue(Item.PlayerId, Name))
+	{
+		IdByName.Remove(Name);
+		Scoreboard.RemovePlayer(Name);
+		OnScoreboardChanged.Broadcast();
+	}
+}
+
+void ADeathMatchGameState::GetLifetimeReplicatedProps(
+	TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME_CONDITION(ADeathMatchGameState, PlayerNames, COND_None);
+	DOREPLIFETIME_CONDITION(ADeathMatchGameState, PlayerScores, COND_None);
+}
@@ -0,0 +1,219 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DeathMatchScoreboard.h"
+#include "HAL/IConsoleManager.h"
+
+int32 FDeathMatchScoreboard::AddPlayer(FName PlayerName)
+{
+	EnsureIndex();
+	if (const int32* Rank = RankByName.Find(PlayerName))
+		return *Rank;
+
+	// Appended below every score, then moved up to its place with score 0
+	FDeathMatchPlayerData Data;
+	Data.PlayerName = PlayerName;
+	Data.PlayerScore = MIN_int32;
+	const int32 Index = Ranked.Add(Data);
+	RankByName.Add(PlayerName, Index);
+	return MoveToRank(Index, 0);
+}
+
+bool FDeathMatchScoreboard::RemovePlayer(FName PlayerName)
+{
+	EnsureIndex();
+	int32 Index;
+	if (!RankByName.RemoveAndCopyValue(PlayerName, Index))
+		return false;
+	Ranked.RemoveAt(Index, 1, false);
+	ReindexRange(Index, Ranked.Num() - 1);
+	return true;
+}
+
+int32 FDeathMatchScoreboard::AddScore(FName PlayerName, int32 Delta)
+{
+	const int32 Index = AddPlayer(PlayerName);
+	return MoveToRank(Index, Ranked[Index].PlayerScore + Delta);
+}
+
+int32 FDeathMatchScoreboard::SetScore(FName PlayerName, int32 Score)
+{
+	return MoveToRank(AddPlayer(PlayerName), Score);
+}
+
+int32 FDeathMatchScoreboard::GetRank(FName PlayerName) const
+{
+	EnsureIndex();
+	const int32* Rank = RankByName.Find(PlayerName);
+	return Rank ? *Rank : INDEX_NONE;
+}
+
+const FDeathMatchPlayerData* FDeathMatchScoreboard::Find(FName PlayerName) const
+{
+	EnsureIndex();
+	const int32* Rank = RankByName.Find(PlayerName);
+	return Rank ? &Ranked[*Rank] : nullptr;
+}
+
+void FDeathMatchScoreboard::Reset()
+{
+	Ranked.Reset();
+	RankByName.Reset();
+}
+
+int32 FDeathMatchScoreboard::MoveToRank(int32 Index, int32 NewScore)
+{
+	const int32 OldScore = Ranked[Index].PlayerScore;
+	// Entries with the same score keep their order, the moved entry goes behind them
+	int32 NewIndex = Index;
+	if (NewScore > OldScore)
+	{
+		int32 Low = 0, High = Index;
+		while (Low < High)
+		{
+			const int32 Mid = (Low + High) / 2;
+			if (Ranked[Mid].PlayerScore >= NewScore)
+				Low = Mid + 1;
+			else
+				High = Mid;
+		}
+		NewIndex = Low;
+	}
+	else if (NewScore < OldScore)
+	{
+		int32 Low = Index + 1, High = Ranked.Num();
+		while (Low < High)
+		{
+			const int32 Mid = (Low + High) / 2;
+			if (Ranked[Mid].PlayerScore >= NewScore)
+				Low = Mid + 1;
+			else
+				High = Mid;
+		}
+		NewIndex = Low - 1;
+	}
+
+	FDeathMatchPlayerData Moved = MoveTemp(Ranked[Index]);
+	Moved.PlayerScore = NewScore;
+	if (NewIndex < Index)
+	{
+		for (int32 i = Index; i > NewIndex; --i)
+			Ranked[i] = MoveTemp(Ranked[i - 1]);
+	}
+	else
+	{
+		for (int32 i = Index; i < NewIndex; ++i)
+			Ranked[i] = MoveTemp(Ranked[i + 1]);
+	}
+	Ranked[NewIndex] = MoveTemp(Moved);
+	ReindexRange(FMath::Min(Index, NewIndex), FMath::Max(Index, NewIndex));
+	return NewIndex;
+}
+
+void FDeathMatchScoreboard::ReindexRange(int32 First, int32 Last)
+{
+	for (int32 i = First; i <= Last; ++i)
+	{
+		RankByName.Add(Ranked[i].PlayerName, i);
+	}
+}
+
+void FDeathMatchScoreboard::EnsureIndex() const
+{
+	if (RankByName.Num() != Ranked.Num())
+		RebuildIndex();
+}
+
+void FDeathMatchScoreboard::RebuildIndex() const
+{
+	RankByName.Reset();
+	for (int32 i = 0; i < Ranked.Num(); ++i)
+	{
+		RankByName.Add(Ranked[i].PlayerName, i);
+	}
+}
+
+int32 UDeathMatchScoreboardLibrary::AddPlayerScore(FDeathMatchScoreboard& Board, FName PlayerName, int32 Delta)
+{
+	return Board.AddScore(PlayerName, Delta);
+}
+
+bool UDeathMatchScoreboardLibrary::RemovePlayer(FDeathMatchScoreboard& Board, FName PlayerName)
+{
+	return Board.RemovePlayer(PlayerName);
+}
+
+int32 UDeathMatchScoreboardLibrary::GetPlayerRank(const FDeathMatchScoreboard& Board, FName PlayerName)
+{
+	return Board.GetRank(PlayerName);
+}
+
+bool UDeathMatchScoreboardLibrary::GetEntryAtRank(const FDeathMatchScoreboard& Board, int32 Rank,
+	FDeathMatchPlayerData& OutData)
+{
+	if (!Board.GetRanked().IsValidIndex(Rank))
+		return false;
+	OutData = Board.GetRanked()[Rank];
+	return true;
+}
+
+int32 UDeathMatchScoreboardLibrary::GetNumPlayers(const FDeathMatchScoreboard& Board)
+{
+	return Board.Num();
+}
+
+void UDeathMatchScoreboardLibrary::GetTopPlayers(const FDeathMatchScoreboard& Board, int32 K,
+	TArray<FDeathMatchPlayerData>& OutTop)
+{
+	OutTop = Board.GetTopK(K);
+}
+
+#if !UE_BUILD_SHIPPING
+// Homework.Scoreboard.Bench <Players> <Kills>: incremental board against SortValues after every kill,
+// e.g. "64 10000" for a full lobby or "1024 10000" for a board with many AI
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice ScoreboardBenchCommand(
+	TEXT("Homework.Scoreboard.Bench"),
+	TEXT("Compare the incremental scoreboard with SortValues. Args: Players (64) Kills (10000)"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+		[](const TArray<FString>& Args, UWorld*, FOutputDevice& Ar)
+	{
+		const int32 NumPlayers = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 64;
+		const int32 NumKills = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 10000;
+		FRandomStream Random(NumPlayers);
+
+		TArray<FName> Names;
+		for (int32 i = 0; i < NumPlayers; ++i)
+			Names.Add(FName(TEXT("Player"), i));
+
+		FDeathMatchScoreboard Board;
+		TArray<FDeathMatchPlayerData> Values;
+		for (const FName& Name : Names)
+		{
+			Board.AddPlayer(Name);
+			FDeathMatchPlayerData Data;
+			Data.PlayerName = Name;
+			Values.Add(Data);
+		}
+
+		double Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumKills; ++i)
+			Board.AddScore(Names[Random.RandHelper(NumPlayers)], 1);
+		const double IncrementalTime = FPlatformTime::Seconds() - Start;
+
+		Random.Reset();
+		Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumKills; ++i)
+		{
+			const FName& Killer = Names[Random.RandHelper(NumPlayers)];
+			Values.FindByPredicate([&Killer](const FDeathMatchPlayerData& Data)
+			{
+				return Data.PlayerName == Killer;
+			})->PlayerScore += 1;
+			UKisMetMultiFPSLibrary::SortValues(Values);
+		}
+		const double SortTime = FPlatformTime::Seconds() - Start;
+
+		Ar.Logf(TEXT("Scoreboard %d players, %d kills: incremental %.3f ms, SortValues %.3f ms"),
+			NumPlayers, NumKills, IncrementalTime * 1000.0, SortTime * 1000.0);
+	}));
+#endif
@@ -4,7 +4,10 @@
 #include "Kismet/KismetMathLibrary.h"
 #include "../HomeworkCharacter.h"
 #include "AICharacter.h"
-#include "GameFramework/ProjectileMovementComponent.h"
+#include "MatchJournal.h"
+#include "MemoryTags.h"
+#include "HitchCapture.h"
+#include "PropPhysicsManager.h"
 
 // Sets default values
 AGrenade::AGrenade()
@@ -14,7 +17,7 @@ AGrenade::AGrenade()
 	CollisionComp = CreateDefaultSubobject<USphereComponent>(TEXT("SphereComp"));
 	CollisionComp->InitSphereRadius(5.0f);
 	CollisionComp->BodyInstance.SetCollisionProfileName("Projectile");
-	CollisionComp->OnComponentHit.AddDynamic(this, &AGrenade::OnHit);		// set up a notification for when this component hits something blocking
+	// Kinematic movement raises no OnComponentHit, CheckPropHit sweeps for OnHit instead
 
 	// Players can't walk on it
 	CollisionComp->SetWalkableSlopeOverride(FWalkableSlopeOverride(WalkableSlope_Unwalkable, 0.f));
@@ -22,14 +25,11 @@ AGrenade::AGrenade()
 	// Set as root component
 	RootComponent = CollisionComp;
 
-
-	// Use a ProjectileMovementComponent to govern this projectile's movement
-	ProjectileMovement = CreateDefaultSubobject<UProjectileMovementComponent>(TEXT("ProjectileComp"));
-	ProjectileMovement->UpdatedComponent = CollisionComp;
-	ProjectileMovement->InitialSpeed = 2000.f;
-	ProjectileMovement->MaxSpeed = 2000.f;
-	ProjectileMovement->bRotationFollowsVelocity = true;
-	ProjectileMovement->bShouldBounce = true;
+	// Moved along a precomputed FGrenadeTrajectory instead of a ProjectileMovementComponent
+	LaunchSpeed = 2000.0f;
+	FuseTime = 3.0f;
+	FlightTime = 0.0f;
+	TrajectorySeed = 0;
 
 	// Die after 3 seconds by default
 	LifeSpan = 5.0f;
@@ -48,7 +48,78 @@ void AGrenade::BeginPlay()
 void AGrenade::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
-	
+	if (!Trajectory.IsSolved())
+		return;
+
+	const FVector From = GetActorLocation();
+	FlightTime = FMath::Min(FlightTime + DeltaTime, FuseTime);
+	const FVector To = Trajectory.Sample(FlightTime);
+	if (GrenadeOwner && GrenadeOwner->HasAuthority())
+	{
+		if (CheckPawnDeflection(From, To))
+			return;
+		CheckPropHit(From, To);
+	}
+
+	const FVector Velocity = Trajectory.SampleVelocity(FlightTime);
+	if (Velocity.IsNearlyZero())
+		SetActorLocation(To);
+	else
+		SetActorLocationAndRotation(To, Velocity.Rotation());
+}
+
+void AGrenade::Launch(AHomeworkCharacter* InOwner, const FVector& Location, const FRotator& Rotation, int32 Seed)
+{
+	GrenadeOwner = InOwner;
+	TrajectorySeed = Seed;
+	FlightTime = 0.0f;
+	Trajectory.Radius = CollisionComp->GetUnscaledSphereRadius();
+	Trajectory.Solve(GetWorld(), Location, Rotation.Vector() * LaunchSpeed, Seed, 0.0f, FuseTime, this);
+	SetActorLocationAndRotation(Location, Rotation);
+}
+
+void AGrenade::ApplyCorrection(const FVector& Location, const FVector& Velocity, float Time)
+{
+	Trajectory.Solve(GetWorld(), Location, Velocity, TrajectorySeed, Time, FuseTime, this);
+	FlightTime = FMath::Max(FlightTime, Time);
+	SetActorLocation(Trajectory.Sample(FlightTime));
+}
+
+bool AGrenade::CheckPawnDeflection(const FVector& From, const FVector& To)
+{
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(GrenadePawnCheck), false, this);
+	Params.AddIgnoredActor(GrenadeOwner);
+	Params.AddIgnoredActor(LastDeflector.Get());
+	FHitResult Hit;
+	if (!GetWorld()->SweepSingleByObjectType(Hit, From, To, FQuat::Identity, FCollisionObjectQueryParams(ECC_Pawn),
+		FCollisionShape::MakeSphere(Trajectory.Radius), Params) || Hit.bStartPenetrating)
+		return false;
+
+	FVector Velocity = Trajectory.SampleVelocity(FlightTime);
+	Velocity -= (1.0f + Trajectory.Bounciness) * (Velocity | Hit.Normal) * Hit.Normal;
+	LastDeflector = Hit.GetActor();
+	GrenadeOwner->MultiGrenadeCorrect(FGrenadeTrajectory::QuantizeLocation(Hit.Location),
+		FGrenadeTrajectory::QuantizeVelocity(Velocity), FlightTime);
+	return true;
+}
+
+void AGrenade::CheckPropHit(const FVector& From, const FVector& To)
+{
+	// Props don't change the flight, the static solve already bounces off their initial pose
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(GrenadePropCheck), false, this);
+	Params.AddIgnoredActor(GrenadeOwner);
+	FHitResult Hit;
+	if (!GetWorld()->SweepSingleByObjectType(Hit, From, To, FQuat::Identity,
+		FCollisionObjectQueryParams(ECC_PhysicsBody), FCollisionShape::MakeSphere(Trajectory.Radius), Params))
+	{
+		LastPushed.Reset();
+		return;
+	}
+	// Once per contact, not every frame the grenade rests against it
+	if (Hit.GetComponent() == LastPushed.Get())
+		return;
+	LastPushed = Hit.GetComponent();
+	OnHit(CollisionComp, Hit.GetActor(), Hit.GetComponent(), FVector::ZeroVector, Hit);
 }
 
 void AGrenade::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp,
@@ -57,7 +128,7 @@ void AGrenade::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiv
 	// Only add impulse and destroy projectile if we hit a physics
 	if ((OtherActor != nullptr) && (OtherActor != this) && (OtherComp != nullptr) && OtherComp->IsSimulatingPhysics())
 	{
-		OtherComp->AddImpulseAtLocation(GetVelocity(), GetActorLocation());
+		UPropPhysicsManager::AddImpulseAtLocation(OtherComp, Trajectory.SampleVelocity(FlightTime), Hit.ImpactPoint);
 
 		//Destroy();
 	}
@@ -65,38 +136,52 @@ void AGrenade::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiv
 
 void AGrenade::PlayExplosion(AHomeworkCharacter* HomeWorkCharactor)
 {
+	HITCH_SCOPE("AGrenade::PlayExplosion");
+	FHitchCapture::Get().AddEvent(TEXT("Explosion"), this);
 	GrenadeOwner = HomeWorkCharactor;
+	// Explode where the trajectory says, whatever the frame timing was
+	if (Trajectory.IsSolved())
+		SetActorLocation(Trajectory.Sample(FuseTime));
+	// Grenades are spawned locally everywhere, ask the owner who is the server
+	if (GrenadeOwner && GrenadeOwner->HasAuthority())
+	{
+		FMatchJournal::Get().Record(EMatchEventType::Grenade, GrenadeOwner, this, GetActorLocation(), ExploRange);
+	}
 	if (CollisionComp->GetNumChildrenComponents() > 0)
 	{
 		USceneComponent* sphere = CollisionComp->GetChildComponent(0);
 		sphere->SetVisibility(false);
-		UGameplayStatics::PlaySoundAtLocation(GetWorld(), FireSound, GetActorLocation());
-		UGameplayStatics::SpawnEmitterAttached(MuzzleFlash, sphere, TEXT("StaticMesh"),
-			FVector::ZeroVector, FRotator::ZeroRotator, FVector::OneVector,
-			EAttachLocation::KeepRelativeOffset, true, EPSCPoolMethod::None, true);
+		{
+			LLM_SCOPE_BYTAG(Homework_Effects);
+			UGameplayStatics::PlaySoundAtLocation(GetWorld(), FireSound, GetActorLocation());
+			UGameplayStatics::SpawnEmitterAttached(MuzzleFlash, sphere, TEXT("StaticMesh"),
+				FVector::ZeroVector, FRotator::ZeroRotator, FVector::OneVector,
+				EAttachLocation::KeepRelativeOffset, true, EPSCPoolMethod::None, true);
+		}
 		// 
-		TSet<AActor*> HitActor;
+		TSet<AActor*, DefaultKeyFuncs<AActor*>, TInlineSetAllocator<16>> HitActor;
 		FVector CameraLocation = GetActorLocation();
 		FRotator ForwardRotator(5.0f, 0, 0);
+		// Same query as the Visibility LineTraceSingle, built once for all 360 rays
+		FCollisionQueryParams Params(SCENE_QUERY_STAT(GrenadeExplosion), false, this);
+		Params.bReturnPhysicalMaterial = true;
 		for (float angle = 0.0f; angle < 360.0f; angle += 1.0f)
 		{
 			ForwardRotator.Yaw += angle;
 			FVector CameraForwardVector = UKismetMathLibrary::GetForwardVector(ForwardRotator);
 			FVector EndLocation;
-			TArray<AActor*> IgnoreArray;
-			IgnoreArray.Add(this);
 			FHitResult HitResult;
 			EndLocation = CameraLocation + CameraForwardVector * ExploRange;
-			bool HitSuccess = UKismetSystemLibrary::LineTraceSingle(GetWorld(), CameraLocation, EndLocation,
-				ETraceTypeQuery::TraceTypeQuery1, false, IgnoreArray, EDrawDebugTrace::None,
-				HitResult, true);
+			bool HitSuccess = GetWorld()->LineTraceSingleByChannel(HitResult, CameraLocation, EndLocation,
+				ECC_Visibility, Params);
 			if (HitSuccess)
 			{
 				if ((HitResult.Component).Get()->IsSimulatingPhysics())
 				{
 					if (!HitActor.Find((HitResult.Actor).Get()))
 					{
-						(HitResult.Component).Get()->AddImpulseAtLocation(CameraForwardVector * Impulse, GetActorLocation());
+						UPropPhysicsManager::AddImpulseAtLocation((HitResult.Component).Get(), CameraForwardVector * Impulse,
+							GetActorLocation());
 						HitActor.Add((HitResult.Actor).Get());
 					}
 				}
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GrenadeTrajectory.h"
+#include "Engine/World.h"
+#include "Math/RandomStream.h"
+
+void FGrenadeTrajectory::Solve(const UWorld* World, const FVector& Location, const FVector& Velocity, int32 Seed,
+	float InStartTime, float EndTime, const AActor* IgnoreActor)
+{
+	StartTime = InStartTime;
+	const int32 NumSteps = FMath::Max(FMath::CeilToInt((EndTime - StartTime) / StepTime), 1);
+	Points.Reset(NumSteps + 1);
+	Velocities.Reset(NumSteps + 1);
+
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(GrenadeTrajectory), false, IgnoreActor);
+	const FCollisionObjectQueryParams StaticOnly(ECC_WorldStatic);
+	const FCollisionShape Sphere = FCollisionShape::MakeSphere(Radius);
+	const float GravityZ = World->GetGravityZ();
+	FRandomStream Stream(Seed);
+
+	FVector Position = Location;
+	FVector CurVelocity = Velocity;
+	bool bResting = false;
+	Points.Add(Position);
+	Velocities.Add(CurVelocity);
+
+	for (int32 Step = 0; Step < NumSteps; ++Step)
+	{
+		if (!bResting)
+		{
+			CurVelocity.Z += GravityZ * StepTime;
+			float TimeLeft = StepTime;
+			// A few bounces per step, enough for corners
+			for (int32 Iteration = 0; Iteration < 3 && TimeLeft > KINDA_SMALL_NUMBER; ++Iteration)
+			{
+				const FVector End = Position + CurVelocity * TimeLeft;
+				FHitResult Hit;
+				if (!World->SweepSingleByObjectType(Hit, Position, End, FQuat::Identity, StaticOnly, Sphere, Params))
+				{
+					Position = End;
+					break;
+				}
+
+				Position = Hit.Location;
+				TimeLeft *= 1.0f - Hit.Time;
+				const FVector Normal = Hit.Normal;
+				const FVector NormalVelocity = (CurVelocity | Normal) * Normal;
+				CurVelocity = (CurVelocity - NormalVelocity) * (1.0f - Friction) - NormalVelocity * Bounciness;
+
+				if (Normal.Z > 0.7f && CurVelocity.SizeSquared() < FMath::Square(20.0f))
+				{
+					CurVelocity = FVector::ZeroVector;
+					bResting = true;
+					break;
+				}
+				const float Speed = CurVelocity.Size();
+				CurVelocity = Stream.VRandCone(CurVelocity / Speed, FMath::DegreesToRadians(BounceSpread)) * Speed;
+				// Never deflect back into the surface
+				if ((CurVelocity | Normal) < 0.0f)
+					CurVelocity -= 2.0f * (CurVelocity | Normal) * Normal;
+			}
+		}
+		Points.Add(Position);
+		Velocities.Add(CurVelocity);
+	}
+}
+
+FVector FGrenadeTrajectory::Sample(float Time) const
+{
+	if (Points.Num() == 0)
+		return FVector::ZeroVector;
+	const float Index = FMath::Clamp((Time - StartTime) / StepTime, 0.0f, float(Points.Num() - 1));
+	const int32 Lower = FMath::FloorToInt(Index);
+	const int32 Upper = FMath::Min(Lower + 1, Points.Num() - 1);
+	return FMath::Lerp(Points[Lower], Points[Upper], Index - Lower);
+}
+
+FVector FGrenadeTrajectory::SampleVelocity(float Time) const
+{
+	if (Velocities.Num() == 0)
+		return FVector::ZeroVector;
+	const int32 Index = FMath::Clamp(FMath::RoundToInt((Time - StartTime) / StepTime), 0, Velocities.Num() - 1);
+	return Velocities[Index];
+}
+
+FVector FGrenadeTrajectory::QuantizeLocation(const FVector& Location)
+{
+	// FVector_NetQuantize
+	return FVector(FMath::RoundToFloat(Location.X), FMath::RoundToFloat(Location.Y), FMath::RoundToFloat(Location.Z));
+}
+
+FVector FGrenadeTrajectory::QuantizeVelocity(const FVector& Velocity)
+{
+	// FVector_NetQuantize10
+	return FVector(FMath::RoundToFloat(Velocity.X * 10.0f), FMath::RoundToFloat(Velocity.Y * 10.0f),
+		FMath::RoundToFloat(Velocity.Z * 10.0f)) / 10.0f;
+}
+
+FRotator FGrenadeTrajectory::QuantizeRotation(const FRotator& Rotation)
+{
+	// FRotator::NetSerialize sends 16 bits per axis
+	return FRotator(
+		FRotator::DecompressAxisFromShort(FRotator::CompressAxisToShort(Rotation.Pitch)),
+		FRotator::DecompressAxisFromShort(FRotator::CompressAxisToShort(Rotation.Yaw)),
+		FRotator::DecompressAxisFromShort(FRotator::CompressAxisToShort(Rotation.Roll)));
+}
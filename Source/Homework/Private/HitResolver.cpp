@@ -0,0 +1,321 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HitResolver.h"
+#include "Homework.h"
+#include "../HomeworkCharacter.h"
+#include "AICharacter.h"
+#include "HitchCapture.h"
+#include "ShotTrace.h"
+#include "WeaponBaseServer.h"
+#include "CollisionQueryParams.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+
+// One per worker for a batch. Small enough for the task graph's recycled task pool, where
+// ParallelFor allocates its bookkeeping on every call
+class FHitResolveTask
+{
+public:
+	explicit FHitResolveTask(UHitResolver& InResolver)
+		: Resolver(InResolver)
+	{
+	}
+
+	static ESubsequentsMode::Type GetSubsequentsMode() { return ESubsequentsMode::TrackSubsequents; }
+	ENamedThreads::Type GetDesiredThread() { return ENamedThreads::AnyHiPriThreadHiPriTask; }
+	TStatId GetStatId() const { RETURN_QUICK_DECLARE_CYCLE_STAT(FHitResolveTask, STATGROUP_TaskGraphTasks); }
+
+	void DoTask(ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+	{
+		Resolver.ResolveShots();
+	}
+
+private:
+	UHitResolver& Resolver;
+};
+
+DECLARE_CYCLE_STAT(TEXT("Hit Resolve"), STAT_HitResolve, STATGROUP_Homework);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hit Resolve Rays"), STAT_HitResolveRays, STATGROUP_Homework);
+
+static TAutoConsoleVariable<int32> CVarHitsParallel(
+	TEXT("Homework.Hits.Parallel"),
+	1,
+	TEXT("Resolve the shots of a tick as one batch on worker threads. 0 resolves each shot on the game thread when it arrives."));
+
+static TAutoConsoleVariable<int32> CVarHitsMinParallelRays(
+	TEXT("Homework.Hits.MinParallelRays"),
+	8,
+	TEXT("Smaller batches are resolved on the game thread, the task overhead is not worth it."));
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice HitsBenchCommand(
+	TEXT("Homework.Hits.Bench"),
+	TEXT("Resolve a random batch of shots at the characters serially and in parallel and compare. Args: Shots (256)"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+		[](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		UHitResolver* Resolver = World ? World->GetSubsystem<UHitResolver>() : nullptr;
+		if (!Resolver || World->GetNetMode() == NM_Client)
+		{
+			Ar.Logf(TEXT("Hit resolve bench needs authority"));
+			return;
+		}
+		Resolver->Bench(Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 256, Ar);
+	}));
+#endif
+
+bool UHitResolver::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void UHitResolver::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(
+		FOnActorSpawned::FDelegate::CreateUObject(this, &UHitResolver::OnActorSpawned));
+}
+
+void UHitResolver::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+	// Characters placed in the level were loaded, not spawned
+	for (TActorIterator<ACharacter> It(&InWorld); It; ++It)
+	{
+		Targets.AddUnique(*It);
+	}
+}
+
+void UHitResolver::Deinitialize()
+{
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	Shots.Reset();
+	Targets.Reset();
+	Super::Deinitialize();
+}
+
+void UHitResolver::OnActorSpawned(AActor* Actor)
+{
+	if (ACharacter* Character = Cast<ACharacter>(Actor))
+	{
+		Targets.Add(Character);
+	}
+}
+
+void UHitResolver::Tick(float DeltaTime)
+{
+	Flush();
+}
+
+ETickableTickType UHitResolver::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UHitResolver::IsTickable() const
+{
+	return Shots.Num() > 0;
+}
+
+TStatId UHitResolver::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHitResolver, STATGROUP_Tickables);
+}
+
+UWorld* UHitResolver::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void UHitResolver::Submit(AHomeworkCharacter* Shooter, const FVector& Start, TArrayView<const FVector> Ends,
+	const FVector& Forward)
+{
+	UWorld* World = Shooter->GetWorld();
+	UHitResolver* Resolver = World ? World->GetSubsystem<UHitResolver>() : nullptr;
+	const AWeaponBaseServer* Weapon = Shooter->GetCurrentServerWeapon();
+	if (!Resolver || !Weapon)
+		return;
+	Resolver->Queue(Shooter, Start, Ends, Forward, Weapon->BaseDamage, FShotTrace::Get().GetCurrentShot());
+	if (CVarHitsParallel.GetValueOnGameThread() == 0)
+		Resolver->Flush();
+}
+
+void UHitResolver::Queue(AHomeworkCharacter* Shooter, const FVector& Start, TArrayView<const FVector> Ends,
+	const FVector& Forward, float BaseDamage, uint32 ShotId)
+{
+	Shots.Add({ Shooter, Start, Forward, BaseDamage, ShotId, RayEnds.Num(), Ends.Num() });
+	for (const FVector& End : Ends)
+	{
+		RayStarts.Add(Start);
+		RayEnds.Add(End);
+	}
+}
+
+void UHitResolver::Flush()
+{
+	HITCH_SCOPE("UHitResolver::Flush");
+	Resolve(CVarHitsParallel.GetValueOnGameThread() != 0);
+	Apply();
+}
+
+void UHitResolver::Resolve(bool bParallel)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HitResolve);
+	const int32 NumRays = RayEnds.Num();
+	SET_DWORD_STAT(STAT_HitResolveRays, NumRays);
+
+	// Destroyed characters drop out here
+	Candidates.Reset();
+	for (int32 i = Targets.Num() - 1; i >= 0; --i)
+	{
+		if (ACharacter* Target = Targets[i].Get())
+			Candidates.Add(Target);
+		else
+			Targets.RemoveAtSwap(i, 1, false);
+	}
+
+	// Posed once on the game thread, the workers only read the capsules and the physics scene
+	FHitboxQuery::Gather(Candidates, RayStarts, RayEnds, Characters, Capsules);
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(HitResolverWorldTrace), false);
+	Params.bReturnPhysicalMaterial = true;
+	for (ACharacter* Character : Characters)
+		Params.AddIgnoredActor(Character);
+
+	RayIgnoreOwners.SetNum(NumRays);
+	for (const FQueuedShot& Shot : Shots)
+	{
+		AHomeworkCharacter* Shooter = Shot.Shooter.Get();
+		const int32 Owner = Shooter ? Characters.IndexOfByKey(Shooter) : INDEX_NONE;
+		if (Shooter && Owner == INDEX_NONE)
+			Params.AddIgnoredActor(Shooter);
+		for (int32 i = 0; i < Shot.NumRays; ++i)
+			RayIgnoreOwners[Shot.FirstRay + i] = Owner;
+	}
+
+	RayHits.SetNum(NumRays);
+	RayDamages.SetNum(NumRays);
+	BatchParams = &Params;
+	NextShot = 0;
+	if (bParallel && NumRays >= CVarHitsMinParallelRays.GetValueOnGameThread())
+	{
+		// The game thread takes shots too, one task fewer than there are shots is enough
+		const int32 NumTasks = FMath::Min(FTaskGraphInterface::Get().GetNumWorkerThreads(), Shots.Num() - 1);
+		for (int32 i = 0; i < NumTasks; ++i)
+		{
+			ResolveTasks.Add(TGraphTask<FHitResolveTask>::CreateTask().ConstructAndDispatchWhenReady(*this));
+		}
+	}
+	ResolveShots();
+	if (ResolveTasks.Num() > 0)
+	{
+		FTaskGraphInterface::Get().WaitUntilTasksComplete(ResolveTasks, ENamedThreads::GameThread_Local);
+		ResolveTasks.Reset();
+	}
+	BatchParams = nullptr;
+}
+
+void UHitResolver::ResolveShots()
+{
+	for (int32 ShotIndex = NextShot++; ShotIndex < Shots.Num(); ShotIndex = NextShot++)
+	{
+		ResolveShot(Shots[ShotIndex]);
+	}
+}
+
+void UHitResolver::ResolveShot(const FQueuedShot& Shot)
+{
+	const UWorld* World = GetWorld();
+	for (int32 Ray = Shot.FirstRay; Ray < Shot.FirstRay + Shot.NumRays; ++Ray)
+	{
+		FHitResult& Hit = RayHits[Ray];
+		FHitboxQuery::ResolveRay(World, RayStarts[Ray], RayEnds[Ray], *BatchParams, Characters, Capsules,
+			RayIgnoreOwners[Ray], Hit);
+		const AActor* HitActor = Hit.bBlockingHit ? Hit.GetActor() : nullptr;
+		const bool bCharacter = HitActor
+			&& (HitActor->IsA(AHomeworkCharacter::StaticClass()) || HitActor->IsA(AAICharacter::StaticClass()));
+		RayDamages[Ray] = bCharacter
+			? Shot.BaseDamage * FHitboxQuery::GetDamageMultiplier(FHitboxQuery::GetZone(Hit.PhysMaterial.Get()))
+			: 0.0f;
+	}
+}
+
+void UHitResolver::Apply()
+{
+	for (const FQueuedShot& Shot : Shots)
+	{
+		if (AHomeworkCharacter* Shooter = Shot.Shooter.Get())
+		{
+			Shooter->ApplyResolvedShot(Shot.Start, Shot.Forward, Shot.ShotId,
+				MakeArrayView(RayHits.GetData() + Shot.FirstRay, Shot.NumRays),
+				MakeArrayView(RayDamages.GetData() + Shot.FirstRay, Shot.NumRays), DecalLocations, DecalNormals);
+		}
+	}
+	DecalLocations.Reset();
+	DecalNormals.Reset();
+	Shots.Reset();
+	RayStarts.Reset();
+	RayEnds.Reset();
+}
+
+#if !UE_BUILD_SHIPPING
+void UHitResolver::Bench(int32 NumShots, FOutputDevice& Ar)
+{
+	TArray<ACharacter*> Targets;
+	for (TActorIterator<ACharacter> It(GetWorld()); It; ++It)
+		Targets.Add(*It);
+	if (Targets.Num() == 0)
+	{
+		Ar.Logf(TEXT("Hit resolve bench needs characters in the world"));
+		return;
+	}
+
+	// Rifle shots at every character from around it, nobody applies them
+	Flush();
+	FRandomStream Random(NumShots);
+	for (int32 i = 0; i < NumShots; ++i)
+	{
+		const FVector Target = Targets[i % Targets.Num()]->GetActorLocation();
+		const FVector Start = Target + Random.VRand().GetSafeNormal2D() * Random.FRandRange(300.0f, 3000.0f)
+			+ FVector(0.0f, 0.0f, Random.FRandRange(-50.0f, 100.0f));
+		const FVector Forward = (Target - Start).GetSafeNormal();
+		const FVector End = Start + Forward * 10000.0f + Random.VRand() * 100.0f;
+		Queue(nullptr, Start, MakeArrayView(&End, 1), Forward, 10.0f, 0);
+	}
+
+	double SerialSeconds = FPlatformTime::Seconds();
+	Resolve(false);
+	SerialSeconds = FPlatformTime::Seconds() - SerialSeconds;
+	const TArray<FHitResult> SerialHits = RayHits;
+	const TArray<float> SerialDamages = RayDamages;
+
+	double ParallelSeconds = FPlatformTime::Seconds();
+	Resolve(true);
+	ParallelSeconds = FPlatformTime::Seconds() - ParallelSeconds;
+
+	int32 NumHits = 0;
+	int32 NumMismatches = 0;
+	for (int32 i = 0; i < RayHits.Num(); ++i)
+	{
+		const FHitResult& A = SerialHits[i];
+		const FHitResult& B = RayHits[i];
+		NumHits += SerialDamages[i] > 0.0f ? 1 : 0;
+		if (A.bBlockingHit != B.bBlockingHit || A.Actor != B.Actor || A.Component != B.Component
+			|| A.BoneName != B.BoneName || A.Time != B.Time || SerialDamages[i] != RayDamages[i])
+		{
+			++NumMismatches;
+		}
+	}
+	Shots.Reset();
+	RayStarts.Reset();
+	RayEnds.Reset();
+
+	Ar.Logf(TEXT("Hit resolve x%d, %d characters, %d hit: serial %.3f ms, parallel %.3f ms on %d workers, %d mismatches, %s"),
+		NumShots, Targets.Num(), NumHits, SerialSeconds * 1000.0, ParallelSeconds * 1000.0,
+		FTaskGraphInterface::Get().GetNumWorkerThreads(), NumMismatches, NumMismatches == 0 ? TEXT("PASS") : TEXT("FAIL"));
+}
+#endif
@@ -0,0 +1,477 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Hitbox.h"
+#include "Homework.h"
+#include "HitchCapture.h"
+#include "EngineUtils.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+
+DECLARE_CYCLE_STAT(TEXT("Hitbox Trace"), STAT_HitboxTrace, STATGROUP_Homework);
+
+namespace
+{
+	// One capsule of a physics asset, relative to its bone. The cache does not keep the material
+	// alive, the physics asset's body setups do
+	struct FHitboxCapsuleDef
+	{
+		FName Bone;
+		FTransform Local;
+		float HalfLength;
+		float Radius;
+		TWeakObjectPtr<UPhysicalMaterial> PhysMaterial;
+	};
+
+	// Boxes and convex hulls become the capsule along their longest axis, as wide as the wider of
+	// the other two, which keeps hits inside the shape's silhouette
+	void AddBoxDef(TArray<FHitboxCapsuleDef>& Defs, FName Bone, const FTransform& BoxTransform, const FVector& HalfExtent,
+		UPhysicalMaterial* PhysMaterial)
+	{
+		const int32 Axis = HalfExtent.X >= HalfExtent.Y ? (HalfExtent.X >= HalfExtent.Z ? 0 : 2) : (HalfExtent.Y >= HalfExtent.Z ? 1 : 2);
+		const float Radius = Axis == 0 ? FMath::Max(HalfExtent.Y, HalfExtent.Z)
+			: Axis == 1 ? FMath::Max(HalfExtent.X, HalfExtent.Z) : FMath::Max(HalfExtent.X, HalfExtent.Y);
+		// Capsules run along local Z
+		const FQuat ToAxis = Axis == 0 ? FQuat(FVector::YAxisVector, HALF_PI)
+			: Axis == 1 ? FQuat(FVector::XAxisVector, -HALF_PI) : FQuat::Identity;
+		Defs.Add({Bone, FTransform(ToAxis) * BoxTransform, FMath::Max(HalfExtent[Axis] - Radius, 0.0f), Radius, PhysMaterial});
+	}
+
+	const TArray<FHitboxCapsuleDef>& GetCapsuleDefs(const UPhysicsAsset* PhysicsAsset)
+	{
+		// Hit registration only runs on the game thread
+		check(IsInGameThread());
+		static TMap<TWeakObjectPtr<const UPhysicsAsset>, TArray<FHitboxCapsuleDef>> Cache;
+		if (const TArray<FHitboxCapsuleDef>* Defs = Cache.Find(PhysicsAsset))
+			return *Defs;
+
+		// Unloaded assets never match again, drop them before adding
+		for (auto It = Cache.CreateIterator(); It; ++It)
+		{
+			if (!It->Key.IsValid())
+				It.RemoveCurrent();
+		}
+
+		TArray<FHitboxCapsuleDef>& Defs = Cache.Add(PhysicsAsset);
+		for (const USkeletalBodySetup* BodySetup : PhysicsAsset->SkeletalBodySetups)
+		{
+			if (!BodySetup)
+				continue;
+			// Same fallback as a scene query on a body without a material
+			UPhysicalMaterial* PhysMaterial = BodySetup->PhysMaterial ? BodySetup->PhysMaterial : GEngine->DefaultPhysMaterial;
+			const FKAggregateGeom& AggGeom = BodySetup->AggGeom;
+			for (const FKSphylElem& Sphyl : AggGeom.SphylElems)
+			{
+				Defs.Add({BodySetup->BoneName, Sphyl.GetTransform(), Sphyl.Length * 0.5f, Sphyl.Radius, PhysMaterial});
+			}
+			for (const FKTaperedCapsuleElem& Tapered : AggGeom.TaperedCapsuleElems)
+			{
+				Defs.Add({BodySetup->BoneName, Tapered.GetTransform(), Tapered.Length * 0.5f,
+					FMath::Max(Tapered.Radius0, Tapered.Radius1), PhysMaterial});
+			}
+			for (const FKSphereElem& Sphere : AggGeom.SphereElems)
+			{
+				Defs.Add({BodySetup->BoneName, FTransform(Sphere.Center), 0.0f, Sphere.Radius, PhysMaterial});
+			}
+			for (const FKBoxElem& Box : AggGeom.BoxElems)
+			{
+				AddBoxDef(Defs, BodySetup->BoneName, Box.GetTransform(), FVector(Box.X, Box.Y, Box.Z) * 0.5f, PhysMaterial);
+			}
+			for (const FKConvexElem& Convex : AggGeom.ConvexElems)
+			{
+				const FBox& Box = Convex.ElemBox;
+				if (Box.IsValid)
+				{
+					AddBoxDef(Defs, BodySetup->BoneName, FTransform(Box.GetCenter()) * Convex.GetTransform(), Box.GetExtent(),
+						PhysMaterial);
+				}
+			}
+		}
+		return Defs;
+	}
+
+	FORCEINLINE VectorRegister VectorDot3SoA(const VectorRegister& X1, const VectorRegister& Y1, const VectorRegister& Z1,
+		const VectorRegister& X2, const VectorRegister& Y2, const VectorRegister& Z2)
+	{
+		return VectorMultiplyAdd(X1, X2, VectorMultiplyAdd(Y1, Y2, VectorMultiply(Z1, Z2)));
+	}
+
+	FORCEINLINE VectorRegister VectorSaturate(const VectorRegister& X)
+	{
+		return VectorMin(VectorMax(X, VectorZero()), VectorOne());
+	}
+}
+
+void FHitboxCapsules::Reset()
+{
+	AX.Reset(); AY.Reset(); AZ.Reset();
+	BX.Reset(); BY.Reset(); BZ.Reset();
+	RadiusSq.Reset();
+	Owners.Reset();
+	Bones.Reset();
+	PhysMaterials.Reset();
+	Count = 0;
+}
+
+void FHitboxCapsules::Add(const FVector& A, const FVector& B, float Radius, int32 Owner, FName Bone,
+	const TWeakObjectPtr<UPhysicalMaterial>& PhysMaterial)
+{
+	if (Count == AX.Num())
+	{
+		// Padding lanes have a negative squared radius and can never be hit
+		AX.AddZeroed(4); AY.AddZeroed(4); AZ.AddZeroed(4);
+		BX.AddZeroed(4); BY.AddZeroed(4); BZ.AddZeroed(4);
+		RadiusSq.Append({-1.0f, -1.0f, -1.0f, -1.0f});
+		Owners.Append({INDEX_NONE, INDEX_NONE, INDEX_NONE, INDEX_NONE});
+		Bones.AddDefaulted(4);
+		PhysMaterials.AddDefaulted(4);
+	}
+	AX[Count] = A.X; AY[Count] = A.Y; AZ[Count] = A.Z;
+	BX[Count] = B.X; BY[Count] = B.Y; BZ[Count] = B.Z;
+	RadiusSq[Count] = Radius * Radius;
+	Owners[Count] = Owner;
+	Bones[Count] = Bone;
+	PhysMaterials[Count] = PhysMaterial;
+	++Count;
+}
+
+int32 FHitboxCapsules::Intersect(const FVector& Start, const FVector& End, float& OutTime, int32 IgnoreOwner) const
+{
+	// Closest points between the ray and each capsule axis (segment/segment), then back off to
+	// where the ray enters the radius
+	const FVector Dir = End - Start;
+	const float DirSq = Dir.SizeSquared();
+	if (Count == 0 || DirSq < KINDA_SMALL_NUMBER)
+		return INDEX_NONE;
+
+	const VectorRegister PX = VectorSetFloat1(Start.X);
+	const VectorRegister PY = VectorSetFloat1(Start.Y);
+	const VectorRegister PZ = VectorSetFloat1(Start.Z);
+	const VectorRegister D1X = VectorSetFloat1(Dir.X);
+	const VectorRegister D1Y = VectorSetFloat1(Dir.Y);
+	const VectorRegister D1Z = VectorSetFloat1(Dir.Z);
+	const VectorRegister A = VectorSetFloat1(DirSq);
+	const VectorRegister InvA = VectorSetFloat1(1.0f / DirSq);
+	const VectorRegister InvLength = VectorSetFloat1(FMath::InvSqrt(DirSq));
+	const VectorRegister Epsilon = VectorSetFloat1(SMALL_NUMBER);
+	const VectorRegister NoHit = VectorSetFloat1(BIG_NUMBER);
+
+	float BestTime = BIG_NUMBER;
+	int32 Best = INDEX_NONE;
+	for (int32 i = 0; i < AX.Num(); i += 4)
+	{
+		const VectorRegister CAX = VectorLoad(AX.GetData() + i);
+		const VectorRegister CAY = VectorLoad(AY.GetData() + i);
+		const VectorRegister CAZ = VectorLoad(AZ.GetData() + i);
+		const VectorRegister D2X = VectorSubtract(VectorLoad(BX.GetData() + i), CAX);
+		const VectorRegister D2Y = VectorSubtract(VectorLoad(BY.GetData() + i), CAY);
+		const VectorRegister D2Z = VectorSubtract(VectorLoad(BZ.GetData() + i), CAZ);
+		const VectorRegister RX = VectorSubtract(PX, CAX);
+		const VectorRegister RY = VectorSubtract(PY, CAY);
+		const VectorRegister RZ = VectorSubtract(PZ, CAZ);
+
+		const VectorRegister E = VectorDot3SoA(D2X, D2Y, D2Z, D2X, D2Y, D2Z);
+		const VectorRegister F = VectorDot3SoA(D2X, D2Y, D2Z, RX, RY, RZ);
+		const VectorRegister C = VectorDot3SoA(D1X, D1Y, D1Z, RX, RY, RZ);
+		const VectorRegister B = VectorDot3SoA(D1X, D1Y, D1Z, D2X, D2Y, D2Z);
+
+		const VectorRegister Denom = VectorMax(VectorSubtract(VectorMultiply(A, E), VectorMultiply(B, B)), Epsilon);
+		VectorRegister S = VectorSaturate(VectorDivide(VectorSubtract(VectorMultiply(B, F), VectorMultiply(C, E)), Denom));
+		const VectorRegister T = VectorSaturate(VectorDivide(VectorMultiplyAdd(B, S, F), VectorMax(E, Epsilon)));
+		S = VectorSaturate(VectorMultiply(VectorSubtract(VectorMultiply(B, T), C), InvA));
+
+		const VectorRegister DiffX = VectorSubtract(VectorMultiplyAdd(D1X, S, RX), VectorMultiply(D2X, T));
+		const VectorRegister DiffY = VectorSubtract(VectorMultiplyAdd(D1Y, S, RY), VectorMultiply(D2Y, T));
+		const VectorRegister DiffZ = VectorSubtract(VectorMultiplyAdd(D1Z, S, RZ), VectorMultiply(D2Z, T));
+		const VectorRegister DistSq = VectorDot3SoA(DiffX, DiffY, DiffZ, DiffX, DiffY, DiffZ);
+		const VectorRegister RadSq = VectorLoad(RadiusSq.GetData() + i);
+		const VectorRegister Hit = VectorCompareLE(DistSq, RadSq);
+		if (VectorMaskBits(Hit) == 0)
+			continue;
+
+		const VectorRegister Inside = VectorMax(VectorSubtract(RadSq, DistSq), Epsilon);
+		const VectorRegister Back = VectorMultiply(VectorMultiply(Inside, VectorReciprocalSqrtAccurate(Inside)), InvLength);
+		const VectorRegister Entry = VectorSelect(Hit, VectorMax(VectorSubtract(S, Back), VectorZero()), NoHit);
+
+		float Times[4];
+		VectorStore(Entry, Times);
+		for (int32 Lane = 0; Lane < 4; ++Lane)
+		{
+			if (Times[Lane] < BestTime && Owners[i + Lane] != IgnoreOwner)
+			{
+				BestTime = Times[Lane];
+				Best = i + Lane;
+			}
+		}
+	}
+	OutTime = BestTime;
+	return Best;
+}
+
+int32 FHitboxCapsules::IntersectScalar(const FVector& Start, const FVector& End, float& OutTime, int32 IgnoreOwner) const
+{
+	const FVector Dir = End - Start;
+	const float DirSq = Dir.SizeSquared();
+	if (Count == 0 || DirSq < KINDA_SMALL_NUMBER)
+		return INDEX_NONE;
+
+	float BestTime = BIG_NUMBER;
+	int32 Best = INDEX_NONE;
+	for (int32 i = 0; i < Count; ++i)
+	{
+		if (Owners[i] == IgnoreOwner)
+			continue;
+		const FVector CapsuleA(AX[i], AY[i], AZ[i]);
+		const FVector Axis = FVector(BX[i], BY[i], BZ[i]) - CapsuleA;
+		const FVector R = Start - CapsuleA;
+		const float E = Axis | Axis;
+		const float F = Axis | R;
+		const float C = Dir | R;
+		const float B = Dir | Axis;
+
+		float S = FMath::Clamp((B * F - C * E) / FMath::Max(DirSq * E - B * B, SMALL_NUMBER), 0.0f, 1.0f);
+		const float T = FMath::Clamp((B * S + F) / FMath::Max(E, SMALL_NUMBER), 0.0f, 1.0f);
+		S = FMath::Clamp((B * T - C) / DirSq, 0.0f, 1.0f);
+
+		const float DistSq = (R + Dir * S - Axis * T).SizeSquared();
+		if (DistSq > RadiusSq[i])
+			continue;
+		const float Entry = FMath::Max(S - FMath::Sqrt(FMath::Max(RadiusSq[i] - DistSq, SMALL_NUMBER) / DirSq), 0.0f);
+		if (Entry < BestTime)
+		{
+			BestTime = Entry;
+			Best = i;
+		}
+	}
+	OutTime = BestTime;
+	return Best;
+}
+
+EHitZone FHitboxQuery::GetZone(const UPhysicalMaterial* PhysMaterial)
+{
+	if (!PhysMaterial)
+		return EHitZone::None;
+	switch (PhysMaterial->SurfaceType)
+	{
+	case EPhysicalSurface::SurfaceType1:	return EHitZone::Head;
+	case EPhysicalSurface::SurfaceType2:	return EHitZone::Body;
+	case EPhysicalSurface::SurfaceType3:	return EHitZone::Arm;
+	case EPhysicalSurface::SurfaceType4:	return EHitZone::Leg;
+	default:								return EHitZone::None;
+	}
+}
+
+float FHitboxQuery::GetDamageMultiplier(EHitZone Zone)
+{
+	switch (Zone)
+	{
+	case EHitZone::Head:	return 4.0f;
+	case EHitZone::Arm:		return 0.8f;
+	case EHitZone::Leg:		return 0.7f;
+	default:				return 1.0f;
+	}
+}
+
+namespace
+{
+	template <typename InReachType>
+	void GatherInReach(TArrayView<ACharacter* const> Candidates, const AActor* IgnoreActor, InReachType InReach,
+		TArray<ACharacter*>& OutCharacters, FHitboxCapsules& OutCapsules)
+	{
+		OutCharacters.Reset();
+		OutCapsules.Reset();
+		for (ACharacter* Candidate : Candidates)
+		{
+			USkeletalMeshComponent* Mesh = Candidate ? Candidate->GetMesh() : nullptr;
+			if (Candidate == IgnoreActor || !Mesh || !Mesh->GetPhysicsAsset())
+				continue;
+			const FBoxSphereBounds& Bounds = Mesh->Bounds;
+			if (!InReach(Bounds.Origin, FMath::Square(Bounds.SphereRadius)))
+				continue;
+
+			const int32 Owner = OutCharacters.Add(Candidate);
+			for (const FHitboxCapsuleDef& Def : GetCapsuleDefs(Mesh->GetPhysicsAsset()))
+			{
+				const int32 BoneIndex = Mesh->GetBoneIndex(Def.Bone);
+				if (BoneIndex == INDEX_NONE)
+					continue;
+				const FTransform CapsuleTransform = Def.Local * Mesh->GetBoneTransform(BoneIndex);
+				const FVector HalfAxis = CapsuleTransform.TransformVector(FVector(0.0f, 0.0f, Def.HalfLength));
+				const float Radius = Def.Radius * CapsuleTransform.GetMaximumAxisScale();
+				OutCapsules.Add(CapsuleTransform.GetLocation() - HalfAxis, CapsuleTransform.GetLocation() + HalfAxis,
+					Radius, Owner, Def.Bone, Def.PhysMaterial);
+			}
+		}
+	}
+}
+
+void FHitboxQuery::Gather(TArrayView<ACharacter* const> Candidates, const FVector& Start, TArrayView<const FVector> Ends,
+	const AActor* IgnoreActor, TArray<ACharacter*>& OutCharacters, FHitboxCapsules& OutCapsules)
+{
+	GatherInReach(Candidates, IgnoreActor, [&](const FVector& Origin, float RadiusSq)
+	{
+		return Ends.ContainsByPredicate([&](const FVector& End)
+		{
+			return FMath::PointDistToSegmentSquared(Origin, Start, End) <= RadiusSq;
+		});
+	}, OutCharacters, OutCapsules);
+}
+
+void FHitboxQuery::Gather(TArrayView<ACharacter* const> Candidates, TArrayView<const FVector> Starts,
+	TArrayView<const FVector> Ends, TArray<ACharacter*>& OutCharacters, FHitboxCapsules& OutCapsules)
+{
+	check(Starts.Num() == Ends.Num());
+	GatherInReach(Candidates, nullptr, [&](const FVector& Origin, float RadiusSq)
+	{
+		for (int32 i = 0; i < Ends.Num(); ++i)
+		{
+			if (FMath::PointDistToSegmentSquared(Origin, Starts[i], Ends[i]) <= RadiusSq)
+				return true;
+		}
+		return false;
+	}, OutCharacters, OutCapsules);
+}
+
+bool FHitboxQuery::LineTrace(UWorld* World, TArrayView<ACharacter* const> Candidates, const FVector& Start,
+	const FVector& End, const AActor* IgnoreActor, FHitResult& OutHit)
+{
+	TArray<FHitResult> Hits;
+	LineTraceBatch(World, Candidates, Start, MakeArrayView(&End, 1), IgnoreActor, Hits);
+	OutHit = Hits[0];
+	return OutHit.bBlockingHit;
+}
+
+void FHitboxQuery::LineTraceBatch(UWorld* World, TArrayView<ACharacter* const> Candidates, const FVector& Start,
+	TArrayView<const FVector> Ends, const AActor* IgnoreActor, TArray<FHitResult>& OutHits)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HitboxTrace);
+	HITCH_SCOPE("FHitboxQuery::LineTraceBatch");
+
+	// Capsules are posed once for the whole batch. Batched callers (UHitResolver) keep their own
+	// across shots and call Gather and ResolveRay directly
+	TArray<ACharacter*> Characters;
+	FHitboxCapsules Capsules;
+	Gather(Candidates, Start, Ends, IgnoreActor, Characters, Capsules);
+
+	// Everything but characters still goes through the physics scene
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(HitboxWorldTrace), false, IgnoreActor);
+	Params.bReturnPhysicalMaterial = true;
+	for (ACharacter* Character : Characters)
+		Params.AddIgnoredActor(Character);
+
+	OutHits.SetNum(Ends.Num());
+	for (int32 RayIndex = 0; RayIndex < Ends.Num(); ++RayIndex)
+	{
+		ResolveRay(World, Start, Ends[RayIndex], Params, Characters, Capsules, INDEX_NONE, OutHits[RayIndex]);
+	}
+}
+
+void FHitboxQuery::ResolveRay(const UWorld* World, const FVector& Start, const FVector& End,
+	const FCollisionQueryParams& Params, TArrayView<ACharacter* const> Characters, const FHitboxCapsules& Capsules,
+	int32 IgnoreOwner, FHitResult& OutHit)
+{
+	OutHit = FHitResult(Start, End);
+	const bool bWorldHit = World->LineTraceSingleByChannel(OutHit, Start, End, ECC_Visibility, Params);
+
+	float Time;
+	const int32 Index = Capsules.Intersect(Start, End, Time, IgnoreOwner);
+	if (Index == INDEX_NONE || (bWorldHit && OutHit.Time <= Time))
+		return;
+
+	ACharacter* Character = Characters[Capsules.Owners[Index]];
+	const FVector CapsuleA(Capsules.AX[Index], Capsules.AY[Index], Capsules.AZ[Index]);
+	const FVector CapsuleB(Capsules.BX[Index], Capsules.BY[Index], Capsules.BZ[Index]);
+	const FVector Location = Start + (End - Start) * Time;
+
+	OutHit = FHitResult(Start, End);
+	OutHit.bBlockingHit = true;
+	OutHit.Time = Time;
+	OutHit.Distance = (End - Start).Size() * Time;
+	OutHit.Location = Location;
+	OutHit.ImpactPoint = Location;
+	OutHit.Normal = (Location - FMath::ClosestPointOnSegment(Location, CapsuleA, CapsuleB)).GetSafeNormal();
+	OutHit.ImpactNormal = OutHit.Normal;
+	OutHit.Actor = Character;
+	OutHit.Component = Character->GetMesh();
+	OutHit.BoneName = Capsules.Bones[Index];
+	OutHit.PhysMaterial = Capsules.PhysMaterials[Index];
+}
+
+#if !UE_BUILD_SHIPPING
+// Homework.Hitbox.Bench <Rays>: random rays at the characters in the current world, hitbox path
+// against the physics asset trace, plus hit zone parity and SIMD/scalar kernel agreement
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice HitboxBenchCommand(
+	TEXT("Homework.Hitbox.Bench"),
+	TEXT("Compare hitbox traces with physics scene traces. Args: Rays (1000)"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+		[](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		const int32 NumRays = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000;
+		TArray<ACharacter*> Targets;
+		for (TActorIterator<ACharacter> It(World); It; ++It)
+		{
+			if (It->GetMesh() && It->GetMesh()->GetPhysicsAsset())
+				Targets.Add(*It);
+		}
+		if (Targets.Num() == 0 || NumRays <= 0)
+		{
+			Ar.Logf(TEXT("Hitbox bench needs characters with a physics asset in the world"));
+			return;
+		}
+
+		FRandomStream Random(NumRays);
+		TArray<FVector> Starts, Ends;
+		for (int32 i = 0; i < NumRays; ++i)
+		{
+			const FBoxSphereBounds& Bounds = Targets[Random.RandHelper(Targets.Num())]->GetMesh()->Bounds;
+			const FVector Aim = Bounds.Origin + Random.GetUnitVector() * Bounds.SphereRadius * 0.5f;
+			const FVector Start = Aim + Random.GetUnitVector() * 2000.0f;
+			Starts.Add(Start);
+			Ends.Add(Start + (Aim - Start).GetSafeNormal() * 5000.0f);
+		}
+
+		TArray<FHitResult> TraceHits, HitboxHits;
+		TraceHits.SetNum(NumRays);
+		HitboxHits.SetNum(NumRays);
+		FCollisionQueryParams Params(SCENE_QUERY_STAT(HitboxBench), false);
+		Params.bReturnPhysicalMaterial = true;
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumRays; ++i)
+			World->LineTraceSingleByChannel(TraceHits[i], Starts[i], Ends[i], ECC_Visibility, Params);
+		const double TraceTime = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumRays; ++i)
+			FHitboxQuery::LineTrace(World, Targets, Starts[i], Ends[i], nullptr, HitboxHits[i]);
+		const double HitboxTime = FPlatformTime::Seconds() - StartTime;
+
+		int32 CharacterHits = 0, ZoneMatches = 0, KernelMismatches = 0;
+		TArray<ACharacter*> Characters;
+		FHitboxCapsules Capsules;
+		for (int32 i = 0; i < NumRays; ++i)
+		{
+			if (Cast<ACharacter>(TraceHits[i].GetActor()))
+			{
+				++CharacterHits;
+				if (HitboxHits[i].GetActor() == TraceHits[i].GetActor()
+					&& FHitboxQuery::GetZone(HitboxHits[i].PhysMaterial.Get()) == FHitboxQuery::GetZone(TraceHits[i].PhysMaterial.Get()))
+					++ZoneMatches;
+			}
+			FHitboxQuery::Gather(Targets, Starts[i], MakeArrayView(&Ends[i], 1), nullptr, Characters, Capsules);
+			float SimdTime, ScalarTime;
+			if (Capsules.Intersect(Starts[i], Ends[i], SimdTime) != Capsules.IntersectScalar(Starts[i], Ends[i], ScalarTime))
+				++KernelMismatches;
+		}
+
+		Ar.Logf(TEXT("Hitbox %d rays: physics trace %.2f us/ray, hitbox %.2f us/ray, zone parity %d/%d, kernel mismatches %d"),
+			NumRays, TraceTime * 1e6 / NumRays, HitboxTime * 1e6 / NumRays, ZoneMatches, CharacterHits, KernelMismatches);
+	}));
+#endif
@@ -0,0 +1,212 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HitchCapture.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectGlobals.h"
+
+static TAutoConsoleVariable<int32> CVarHitchCapture(
+	TEXT("Homework.Hitch.Enable"),
+	1,
+	TEXT("Keep gameplay scope timings of the last frames and write them out when a frame goes over budget."));
+
+static TAutoConsoleVariable<float> CVarHitchBudgetMs(
+	TEXT("Homework.Hitch.BudgetMs"),
+	100.0f,
+	TEXT("Game thread frame time that counts as a hitch."));
+
+static TAutoConsoleVariable<int32> CVarHitchFrames(
+	TEXT("Homework.Hitch.Frames"),
+	120,
+	TEXT("Frames kept before a hitch."));
+
+static TAutoConsoleVariable<float> CVarHitchCooldown(
+	TEXT("Homework.Hitch.Cooldown"),
+	10.0f,
+	TEXT("Seconds between two hitch dumps."));
+
+static FAutoConsoleCommandWithOutputDevice HitchDumpCommand(
+	TEXT("Homework.Hitch.Dump"),
+	TEXT("Write the hitch buffer now."),
+	FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+	{
+		Ar.Logf(TEXT("Wrote %s"), *FHitchCapture::Get().Dump(TEXT("Requested from the console")));
+	}));
+
+FHitchCapture& FHitchCapture::Get()
+{
+	static FHitchCapture Instance;
+	return Instance;
+}
+
+void FHitchCapture::Initialize()
+{
+	FCoreDelegates::OnEndFrame.AddRaw(this, &FHitchCapture::OnEndFrame);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.AddRaw(this, &FHitchCapture::OnPostLoadMap);
+}
+
+void FHitchCapture::Shutdown()
+{
+	FCoreDelegates::OnEndFrame.RemoveAll(this);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.RemoveAll(this);
+	Frames.Empty();
+	bEnabled = false;
+}
+
+void FHitchCapture::Reset()
+{
+	Frames.SetNum(FMath::Clamp(CVarHitchFrames.GetValueOnGameThread(), 2, 1000));
+	for (FHitchFrame& Frame : Frames)
+	{
+		Frame.FrameNumber = 0;
+	}
+	Current = 0;
+	Depth = 0;
+	GetFrame() = FHitchFrame();
+	FrameStartTime = FPlatformTime::Seconds();
+}
+
+void FHitchCapture::OnPostLoadMap(UWorld* World)
+{
+	// The load itself is not a gameplay hitch
+	MapName = World ? World->GetMapName() : FString();
+	Reset();
+}
+
+int32 FHitchCapture::BeginScope(const TCHAR* Name)
+{
+	if (!bEnabled || !IsInGameThread())
+		return INDEX_NONE;
+	FHitchFrame& Frame = GetFrame();
+	if (Frame.NumScopes == FHitchFrame::MaxScopes)
+	{
+		++Frame.NumDropped;
+		return INDEX_NONE;
+	}
+	FHitchFrame::FScope& Scope = Frame.Scopes[Frame.NumScopes];
+	Scope.Name = Name;
+	Scope.Ms = 0.0f;
+	Scope.Depth = Depth++;
+	return Frame.NumScopes++;
+}
+
+void FHitchCapture::EndScope(int32 Slot, double StartTime)
+{
+	if (Slot == INDEX_NONE)
+		return;
+	Depth = FMath::Max(Depth - 1, 0);
+	FHitchFrame& Frame = GetFrame();
+	if (Slot < Frame.NumScopes)
+		Frame.Scopes[Slot].Ms = float((FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+void FHitchCapture::AddEvent(const TCHAR* Type, const UObject* Subject)
+{
+	if (!bEnabled || !IsInGameThread())
+		return;
+	FHitchFrame& Frame = GetFrame();
+	if (Frame.NumEvents == FHitchFrame::MaxEvents)
+	{
+		++Frame.NumDropped;
+		return;
+	}
+	FHitchFrame::FEvent& Event = Frame.Events[Frame.NumEvents++];
+	Event.Type = Type;
+	Event.Subject = Subject ? Subject->GetFName() : NAME_None;
+	Event.Ms = float((FPlatformTime::Seconds() - FrameStartTime) * 1000.0);
+}
+
+void FHitchCapture::OnEndFrame()
+{
+	const bool bWasEnabled = bEnabled;
+	bEnabled = CVarHitchCapture.GetValueOnGameThread() != 0;
+	if (!bEnabled)
+		return;
+	if (!bWasEnabled || Frames.Num() != FMath::Clamp(CVarHitchFrames.GetValueOnGameThread(), 2, 1000))
+	{
+		Reset();
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	FHitchFrame& Frame = GetFrame();
+	Frame.FrameNumber = GFrameCounter;
+	Frame.FrameMs = float((Now - FrameStartTime) * 1000.0);
+	if (Frame.FrameMs > CVarHitchBudgetMs.GetValueOnGameThread()
+		&& Now - LastDumpTime > CVarHitchCooldown.GetValueOnGameThread())
+	{
+		Dump(TEXT("Over budget"));
+	}
+
+	Current = (Current + 1) % Frames.Num();
+	GetFrame() = FHitchFrame();
+	Depth = 0;
+	FrameStartTime = FPlatformTime::Seconds();
+}
+
+FString FHitchCapture::Dump(const TCHAR* Reason)
+{
+	LastDumpTime = FPlatformTime::Seconds();
+	if (Frames.Num() == 0)
+		return FString();
+
+	// The frame that blew the budget and its slowest outermost scope go first
+	const FHitchFrame& Hitch = GetFrame();
+	const FHitchFrame::FScope* Worst = nullptr;
+	for (int32 i = 0; i < Hitch.NumScopes; ++i)
+	{
+		if (Hitch.Scopes[i].Depth == 0 && (!Worst || Hitch.Scopes[i].Ms > Worst->Ms))
+			Worst = &Hitch.Scopes[i];
+	}
+
+	FString Text = FString::Printf(TEXT("%s: frame %llu took %.2f ms, budget %.2f ms, map %s%s"), Reason,
+		Hitch.FrameNumber, Hitch.FrameMs, CVarHitchBudgetMs.GetValueOnGameThread(), *MapName, LINE_TERMINATOR);
+	Text += Worst
+		? FString::Printf(TEXT("Slowest gameplay scope: %s %.2f ms%s"), Worst->Name, Worst->Ms, LINE_TERMINATOR)
+		: FString::Printf(TEXT("No gameplay scope in that frame, the time went elsewhere%s"), LINE_TERMINATOR);
+
+	for (int32 Offset = 1; Offset <= Frames.Num(); ++Offset)
+	{
+		const FHitchFrame& Frame = Frames[(Current + Offset) % Frames.Num()];
+		if (Frame.FrameNumber == 0 && &Frame != &Hitch)
+			continue;
+		Text += FString::Printf(TEXT("%sFrame %llu %.2f ms%s"), LINE_TERMINATOR, Frame.FrameNumber, Frame.FrameMs,
+			LINE_TERMINATOR);
+		for (int32 i = 0; i < Frame.NumScopes; ++i)
+		{
+			const FHitchFrame::FScope& Scope = Frame.Scopes[i];
+			Text += FString::Printf(TEXT("  %s%s %.3f ms%s"), FCString::Spc(Scope.Depth * 2), Scope.Name, Scope.Ms,
+				LINE_TERMINATOR);
+		}
+		for (int32 i = 0; i < Frame.NumEvents; ++i)
+		{
+			const FHitchFrame::FEvent& Event = Frame.Events[i];
+			Text += FString::Printf(TEXT("  @%.2f ms %s %s%s"), Event.Ms, Event.Type, *Event.Subject.ToString(),
+				LINE_TERMINATOR);
+		}
+		if (Frame.NumDropped > 0)
+			Text += FString::Printf(TEXT("  (%d scopes or events dropped)%s"), Frame.NumDropped, LINE_TERMINATOR);
+	}
+
+	const FString Path = FPaths::ProfilingDir() / TEXT("Hitches")
+		/ FString::Printf(TEXT("Hitch-%s.log"), *FDateTime::Now().ToString());
+	FFileHelper::SaveStringToFile(Text, *Path);
+	UE_LOG(LogTemp, Warning, TEXT("Hitch %.0f ms in %s, written to %s"), Hitch.FrameMs,
+		Worst ? Worst->Name : TEXT("no gameplay scope"), *Path);
+	return Path;
+}
+
+FHitchScope::FHitchScope(const TCHAR* Name)
+	: Slot(FHitchCapture::Get().BeginScope(Name))
+	, StartTime(Slot == INDEX_NONE ? 0.0 : FPlatformTime::Seconds())
+{
+}
+
+FHitchScope::~FHitchScope()
+{
+	FHitchCapture::Get().EndScope(Slot, StartTime);
+}
@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HomeworkActorChannel.h"
+#include "NetStatsCollector.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Net/DataBunch.h"
+
+UHomeworkActorChannel::UHomeworkActorChannel(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+}
+
+FPacketIdRange UHomeworkActorChannel::SendBunch(FOutBunch* Bunch, bool Merge)
+{
+	// Replays record through the same channel class, only the game connections are accounted
+	if (Bunch && Actor && Connection && Connection->Driver && Connection->Driver->IsServer()
+		&& Connection->Driver->NetDriverName == NAME_GameNetDriver)
+	{
+		FNetStatsCollector::Get().RecordActorBunch(Connection, Actor, Bunch->GetNumBits(), PropertyShadows);
+	}
+	return Super::SendBunch(Bunch, Merge);
+}
+
+bool UNetStatsPackageMap::SerializeObject(FArchive& Ar, UClass* InClass, UObject*& Obj, FNetworkGUID* OutNetGUID)
+{
+	// Only the size and whether it changed matter, the object's address stands in for its guid
+	uint32 Id = Obj ? PointerHash(Obj) : 0;
+	Ar.SerializeIntPacked(Id);
+	return true;
+}
@@ -0,0 +1,283 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HomeworkMovementComponent.h"
+#include "Homework.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Character.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Movement Corrections"), STAT_MovementCorrections, STATGROUP_Homework);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Snapshot Extrapolated Frames"), STAT_SnapshotExtrapolations, STATGROUP_Homework);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Snapshot Starved Frames"), STAT_SnapshotStarved, STATGROUP_Homework);
+
+static TAutoConsoleVariable<int32> CVarSnapshotInterpolation(
+	TEXT("Homework.Movement.SnapshotInterpolation"),
+	1,
+	TEXT("Render simulated proxies from a snapshot buffer behind the server instead of the engine smoothing."));
+
+// Run with "Net PktLag=150" to compare correction counts under latency
+static FAutoConsoleCommand CmdMovementCorrections(
+	TEXT("Homework.Movement.Corrections"),
+	TEXT("Logs and resets the movement corrections received by each local character."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		for (TObjectIterator<UHomeworkMovementComponent> It; It; ++It)
+		{
+			if (It->CharacterOwner && It->CharacterOwner->IsLocallyControlled())
+			{
+				UE_LOG(LogTemp, Log, TEXT("%s: %d movement corrections"),
+					*It->CharacterOwner->GetName(), It->NumCorrections);
+				It->NumCorrections = 0;
+			}
+		}
+	}));
+
+UHomeworkMovementComponent::UHomeworkMovementComponent()
+{
+	MaxWalkSpeed = 600.0f;
+	LowSpeedWalkSpeed = 300.0f;
+	HighSpeedRunSpeed = 1200.0f;
+	bWantsToLowSpeedWalk = false;
+	bWantsToHighSpeedRun = false;
+	NumCorrections = 0;
+	InterpolationDelay = 0.15f;
+	MaxExtrapolationTime = 0.25f;
+	ServerClockOffset = 0.0;
+	bHasServerClockOffset = false;
+	// Simulated proxies place their snapshots by the server's timestamp, not by arrival time
+	bNetworkAlwaysReplicateTransformUpdateTimestamp = true;
+}
+
+void UHomeworkMovementComponent::SetSpeedMode(ESpeedMode Mode)
+{
+	bWantsToLowSpeedWalk = Mode == ESpeedMode::LowSpeedWalk;
+	bWantsToHighSpeedRun = Mode == ESpeedMode::HighSpeedRun;
+}
+
+ESpeedMode UHomeworkMovementComponent::GetSpeedMode() const
+{
+	if (bWantsToHighSpeedRun)
+		return ESpeedMode::HighSpeedRun;
+	if (bWantsToLowSpeedWalk)
+		return ESpeedMode::LowSpeedWalk;
+	return ESpeedMode::Normal;
+}
+
+float UHomeworkMovementComponent::GetMaxSpeed() const
+{
+	if (IsMovingOnGround())
+	{
+		if (bWantsToHighSpeedRun)
+			return HighSpeedRunSpeed;
+		if (bWantsToLowSpeedWalk)
+			return LowSpeedWalkSpeed;
+	}
+	return Super::GetMaxSpeed();
+}
+
+void UHomeworkMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+	bWantsToLowSpeedWalk = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+	bWantsToHighSpeedRun = (Flags & FSavedMove_Character::FLAG_Custom_1) != 0;
+}
+
+FNetworkPredictionData_Client* UHomeworkMovementComponent::GetPredictionData_Client() const
+{
+	if (!ClientPredictionData)
+	{
+		UHomeworkMovementComponent* MutableThis = const_cast<UHomeworkMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Homework(*this);
+	}
+	return ClientPredictionData;
+}
+
+bool UHomeworkMovementComponent::ClientUpdatePositionAfterServerUpdate()
+{
+	// Replayed moves restore their own speed mode, keep the live input for the next move
+	const bool bRealLowSpeedWalk = bWantsToLowSpeedWalk;
+	const bool bRealHighSpeedRun = bWantsToHighSpeedRun;
+	const bool bResult = Super::ClientUpdatePositionAfterServerUpdate();
+	bWantsToLowSpeedWalk = bRealLowSpeedWalk;
+	bWantsToHighSpeedRun = bRealHighSpeedRun;
+	return bResult;
+}
+
+void UHomeworkMovementComponent::OnClientCorrectionReceived(FNetworkPredictionData_Client_Character& ClientData,
+	float TimeStamp, FVector NewLocation, FVector NewVelocity, UPrimitiveComponent* NewBase, FName NewBaseBoneName,
+	bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode)
+{
+	++NumCorrections;
+	INC_DWORD_STAT(STAT_MovementCorrections);
+	Super::OnClientCorrectionReceived(ClientData, TimeStamp, NewLocation, NewVelocity, NewBase, NewBaseBoneName,
+		bHasBase, bBaseRelativePosition, ServerMovementMode);
+}
+
+bool UHomeworkMovementComponent::UseSnapshotInterpolation() const
+{
+	return CVarSnapshotInterpolation.GetValueOnGameThread() != 0 && CharacterOwner
+		&& CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy && GetNetMode() == NM_Client;
+}
+
+void UHomeworkMovementComponent::SmoothCorrection(const FVector& OldLocation, const FQuat& OldRotation,
+	const FVector& NewLocation, const FQuat& NewRotation)
+{
+	if (!UseSnapshotInterpolation() || !HasValidData())
+	{
+		SnapshotBuffer.Reset();
+		Super::SmoothCorrection(OldLocation, OldRotation, NewLocation, NewRotation);
+		return;
+	}
+
+	const double LocalTime = GetWorld()->GetTimeSeconds();
+	const float ServerStamp = CharacterOwner->GetReplicatedServerLastTransformUpdateTimeStamp();
+	// Without a server stamp the arrival time is the best there is
+	const double ServerTime = ServerStamp > 0.0f ? ServerStamp : LocalTime;
+	const double ClockOffset = LocalTime - ServerTime;
+	if (!bHasServerClockOffset || ClockOffset < ServerClockOffset)
+	{
+		ServerClockOffset = ClockOffset;
+		bHasServerClockOffset = true;
+	}
+	else
+	{
+		// Slowly follow a lasting rise in latency
+		ServerClockOffset += (ClockOffset - ServerClockOffset) * 0.01;
+	}
+
+	// Teleports and respawns start over instead of sliding across the map
+	if (!SnapshotBuffer.IsEmpty()
+		&& FVector::DistSquared(SnapshotBuffer.Snapshots.Last().Location, NewLocation) > FMath::Square(NetworkNoSmoothUpdateDistance))
+	{
+		SnapshotBuffer.Reset();
+	}
+	SnapshotBuffer.Add(ServerTime, NewLocation, NewRotation, Velocity);
+	bNetworkSmoothingComplete = false;
+}
+
+void UHomeworkMovementComponent::SmoothClientPosition(float DeltaSeconds)
+{
+	USkeletalMeshComponent* Mesh = CharacterOwner ? CharacterOwner->GetMesh() : nullptr;
+	if (!UseSnapshotInterpolation() || SnapshotBuffer.IsEmpty() || !Mesh || !UpdatedComponent)
+	{
+		Super::SmoothClientPosition(DeltaSeconds);
+		return;
+	}
+
+	const double RenderTime = GetWorld()->GetTimeSeconds() - ServerClockOffset - InterpolationDelay;
+	if (RenderTime > SnapshotBuffer.Snapshots.Last().Time)
+	{
+		INC_DWORD_STAT(STAT_SnapshotExtrapolations);
+	}
+	FVector Location;
+	FQuat Rotation;
+	if (!SnapshotBuffer.Sample(RenderTime, MaxExtrapolationTime, Location, Rotation))
+	{
+		INC_DWORD_STAT(STAT_SnapshotStarved);
+	}
+
+	// The capsule keeps the newest server pose for collision, only the mesh is drawn behind it
+	const FTransform& CapsuleTransform = UpdatedComponent->GetComponentTransform();
+	const FVector RelativeLocation = CapsuleTransform.InverseTransformVectorNoScale(Location - CapsuleTransform.GetLocation())
+		+ CharacterOwner->GetBaseTranslationOffset();
+	const FQuat RelativeRotation = CapsuleTransform.GetRotation().Inverse() * Rotation * CharacterOwner->GetBaseRotationOffset();
+	Mesh->SetRelativeLocationAndRotation(RelativeLocation, RelativeRotation, false, nullptr, ETeleportType::TeleportPhysics);
+}
+
+void FMovementSnapshotBuffer::Add(double Time, const FVector& Location, const FQuat& Rotation, const FVector& Velocity)
+{
+	// Repeated or out of order stamps carry nothing new
+	if (Snapshots.Num() > 0 && Time <= Snapshots.Last().Time)
+		return;
+	if (Snapshots.Num() == 32)
+		Snapshots.RemoveAt(0, 1, false);
+	Snapshots.Add({ Time, Location, Rotation, Velocity });
+}
+
+bool FMovementSnapshotBuffer::Sample(double Time, float MaxExtrapolation, FVector& OutLocation, FQuat& OutRotation) const
+{
+	if (Snapshots.Num() == 0)
+		return false;
+
+	const FSnapshot& Newest = Snapshots.Last();
+	if (Time >= Newest.Time)
+	{
+		OutLocation = Newest.Location + Newest.Velocity * FMath::Min(float(Time - Newest.Time), MaxExtrapolation);
+		OutRotation = Newest.Rotation;
+		return Time - Newest.Time <= MaxExtrapolation;
+	}
+	if (Time <= Snapshots[0].Time)
+	{
+		OutLocation = Snapshots[0].Location;
+		OutRotation = Snapshots[0].Rotation;
+		return true;
+	}
+
+	int32 Index = Snapshots.Num() - 1;
+	while (Snapshots[Index - 1].Time > Time)
+	{
+		--Index;
+	}
+	const FSnapshot& From = Snapshots[Index - 1];
+	const FSnapshot& To = Snapshots[Index];
+	const float Duration = float(To.Time - From.Time);
+	const float Alpha = float(Time - From.Time) / Duration;
+	// Hermite through the replicated velocities keeps turns round at 10 Hz
+	OutLocation = FMath::CubicInterp(From.Location, From.Velocity * Duration, To.Location, To.Velocity * Duration, Alpha);
+	OutRotation = FQuat::Slerp(From.Rotation, To.Rotation, Alpha);
+	return true;
+}
+
+void FSavedMove_Homework::Clear()
+{
+	Super::Clear();
+	bSavedWantsToLowSpeedWalk = false;
+	bSavedWantsToHighSpeedRun = false;
+}
+
+uint8 FSavedMove_Homework::GetCompressedFlags() const
+{
+	uint8 Result = Super::GetCompressedFlags();
+	if (bSavedWantsToLowSpeedWalk)
+		Result |= FLAG_Custom_0;
+	if (bSavedWantsToHighSpeedRun)
+		Result |= FLAG_Custom_1;
+	return Result;
+}
+
+bool FSavedMove_Homework::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	const FSavedMove_Homework* Other = static_cast<const FSavedMove_Homework*>(NewMove.Get());
+	if (bSavedWantsToLowSpeedWalk != Other->bSavedWantsToLowSpeedWalk
+		|| bSavedWantsToHighSpeedRun != Other->bSavedWantsToHighSpeedRun)
+		return false;
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_Homework::SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel,
+	FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+	if (const UHomeworkMovementComponent* Movement = Cast<UHomeworkMovementComponent>(C->GetCharacterMovement()))
+	{
+		bSavedWantsToLowSpeedWalk = Movement->bWantsToLowSpeedWalk;
+		bSavedWantsToHighSpeedRun = Movement->bWantsToHighSpeedRun;
+	}
+}
+
+void FSavedMove_Homework::PrepMoveFor(ACharacter* C)
+{
+	Super::PrepMoveFor(C);
+	if (UHomeworkMovementComponent* Movement = Cast<UHomeworkMovementComponent>(C->GetCharacterMovement()))
+	{
+		Movement->bWantsToLowSpeedWalk = bSavedWantsToLowSpeedWalk;
+		Movement->bWantsToHighSpeedRun = bSavedWantsToHighSpeedRun;
+	}
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_Homework::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_Homework());
+}
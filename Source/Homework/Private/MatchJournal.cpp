@@ -0,0 +1,241 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MatchJournal.h"
+#include "GameFramework/Actor.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static TAutoConsoleVariable<int32> CVarMatchJournalEnable(
+	TEXT("Homework.Journal.Enable"),
+	1,
+	TEXT("Record fire, hit, damage, death, grenade, spawn and pickup events on the server."));
+
+FMatchJournal& FMatchJournal::Get()
+{
+	static FMatchJournal Instance;
+	return Instance;
+}
+
+FMatchJournal::FMatchJournal()
+	: Queue(16384)
+	, NameQueue(4096)
+	, Thread(nullptr)
+	, WakeEvent(nullptr)
+	, bStopping(false)
+	, StartTime(0.0)
+	, NumRecords(0)
+	, DroppedRecords(0)
+{
+	FCoreDelegates::OnPreExit.AddRaw(this, &FMatchJournal::Close);
+}
+
+void FMatchJournal::Record(EMatchEventType Type, const AActor* Instigator, const AActor* Target,
+	const FVector& Location, float Value, uint8 Extra)
+{
+	if (!CVarMatchJournalEnable.GetValueOnGameThread())
+		return;
+	// Grenades and their explosions also run on clients
+	const AActor* Context = Instigator ? Instigator : Target;
+	if (Context && Context->GetNetMode() == NM_Client)
+		return;
+	if (!Thread)
+		Open();
+
+	FMatchEventRecord Record;
+	FMemory::Memzero(Record);
+	Record.Time = FPlatformTime::Seconds() - StartTime;
+	Record.Instigator = GetId(Instigator);
+	Record.Target = GetId(Target);
+	Record.X = Location.X;
+	Record.Y = Location.Y;
+	Record.Z = Location.Z;
+	Record.Value = Value;
+	Record.Type = uint8(Type);
+	Record.Extra = Extra;
+	if (Queue.Enqueue(Record))
+	{
+		++NumRecords;
+	}
+	else
+	{
+		++DroppedRecords;
+	}
+}
+
+uint32 FMatchJournal::GetId(const AActor* Actor)
+{
+	if (!Actor)
+		return 0;
+	const uint32 Id = Actor->GetUniqueID();
+	const FName Name = Actor->GetFName();
+	FName* Named = NamedIds.Find(Id);
+	if (!Named || *Named != Name)
+	{
+		// Keyed by the record about to be queued rather than by time, the decoder applies it exactly there
+		if (!NameQueue.Enqueue({ NumRecords, Id, Name }))
+		{
+			++DroppedRecords;
+			return Id;
+		}
+		NamedIds.Add(Id, Name);
+	}
+	return Id;
+}
+
+FString FMatchJournal::GetNamesPath(const FString& JournalPath)
+{
+	return FPaths::ChangeExtension(JournalPath, TEXT("hwjn"));
+}
+
+void FMatchJournal::Open()
+{
+	if (Thread)
+		return;
+	Path = FPaths::ProjectSavedDir() / TEXT("Journal") /
+		FString::Printf(TEXT("Match-%s.hwj"), *FDateTime::Now().ToString());
+	StartTime = FPlatformTime::Seconds();
+	NumRecords = 0;
+	DroppedRecords = 0;
+	NamedIds.Reset();
+	bStopping = false;
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool();
+	Thread = FRunnableThread::Create(this, TEXT("MatchJournalWriter"), 0, TPri_BelowNormal);
+}
+
+void FMatchJournal::Close()
+{
+	if (!Thread)
+		return;
+	Stop();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	WakeEvent = nullptr;
+	if (DroppedRecords > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("MatchJournal dropped %d records, the writer could not keep up"), DroppedRecords);
+	}
+}
+
+void FMatchJournal::Stop()
+{
+	bStopping = true;
+	if (WakeEvent)
+		WakeEvent->Trigger();
+}
+
+uint32 FMatchJournal::Run()
+{
+	FArchive* Writer = IFileManager::Get().CreateFileWriter(*Path, FILEWRITE_AllowRead);
+	FArchive* NameWriter = IFileManager::Get().CreateFileWriter(*GetNamesPath(Path), FILEWRITE_AllowRead);
+	if (!Writer || !NameWriter)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("MatchJournal can't open %s"), *Path);
+		delete Writer;
+		delete NameWriter;
+		return 1;
+	}
+
+	FMatchJournalHeader Header;
+	FMemory::Memzero(Header);
+	Header.Magic = Magic;
+	Header.Version = Version;
+	Header.RecordSize = sizeof(FMatchEventRecord);
+	Header.StartTicks = FDateTime::Now().GetTicks();
+	Writer->Serialize(&Header, sizeof(Header));
+
+	while (!bStopping)
+	{
+		WakeEvent->Wait(100);
+		Drain(*Writer, *NameWriter);
+	}
+	Drain(*Writer, *NameWriter);
+
+	Writer->Close();
+	delete Writer;
+	NameWriter->Close();
+	delete NameWriter;
+	return 0;
+}
+
+void FMatchJournal::Drain(FArchive& Writer, FArchive& NameWriter)
+{
+	FMatchJournalName Name;
+	bool bNamed = false;
+	while (NameQueue.Dequeue(Name))
+	{
+		const FTCHARToUTF8 Line(*FString::Printf(TEXT("%llu,%u,%s\n"), Name.Record, Name.Id, *Name.Name.ToString()));
+		NameWriter.Serialize((void*)Line.Get(), Line.Length());
+		bNamed = true;
+	}
+	if (bNamed)
+		NameWriter.Flush();
+
+	FMatchEventRecord Records[256];
+	int32 Count = 0;
+	while (Queue.Dequeue(Records[Count]))
+	{
+		if (++Count == UE_ARRAY_COUNT(Records))
+		{
+			Writer.Serialize(Records, sizeof(Records));
+			Count = 0;
+		}
+	}
+	if (Count > 0)
+	{
+		Writer.Serialize(Records, Count * sizeof(FMatchEventRecord));
+	}
+	Writer.Flush();
+}
+
+bool FMatchJournal::ReadFile(const FString& InPath, FMatchJournalHeader& OutHeader, TArray<FMatchEventRecord>& OutRecords,
+	TArray<FMatchJournalName>& OutNames)
+{
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*InPath));
+	if (!Reader || Reader->TotalSize() < int64(sizeof(FMatchJournalHeader)))
+		return false;
+	Reader->Serialize(&OutHeader, sizeof(OutHeader));
+	if (OutHeader.Magic != Magic || OutHeader.RecordSize != sizeof(FMatchEventRecord))
+		return false;
+
+	const int64 NumRecords = (Reader->TotalSize() - sizeof(FMatchJournalHeader)) / sizeof(FMatchEventRecord);
+	OutRecords.SetNumUninitialized(NumRecords);
+	Reader->Serialize(OutRecords.GetData(), NumRecords * sizeof(FMatchEventRecord));
+	if (Reader->IsError())
+		return false;
+
+	// Version 2 tables are keyed by time, their ids are left unnamed
+	TArray<FString> Lines;
+	if (OutHeader.Version >= 3)
+		FFileHelper::LoadFileToStringArray(Lines, *GetNamesPath(InPath));
+	for (const FString& Line : Lines)
+	{
+		TArray<FString> Fields;
+		if (Line.ParseIntoArray(Fields, TEXT(",")) == 3)
+		{
+			OutNames.Add({ FCString::Strtoui64(*Fields[0], nullptr, 10), uint32(FCString::Strtoui64(*Fields[1], nullptr, 10)), FName(*Fields[2]) });
+		}
+	}
+	return true;
+}
+
+const TCHAR* FMatchJournal::GetTypeName(uint8 Type)
+{
+	switch (EMatchEventType(Type))
+	{
+	case EMatchEventType::Fire:		return TEXT("Fire");
+	case EMatchEventType::Hit:		return TEXT("Hit");
+	case EMatchEventType::Damage:	return TEXT("Damage");
+	case EMatchEventType::Death:	return TEXT("Death");
+	case EMatchEventType::Grenade:	return TEXT("Grenade");
+	case EMatchEventType::Spawn:	return TEXT("Spawn");
+	case EMatchEventType::Pickup:	return TEXT("Pickup");
+	default:						return TEXT("Unknown");
+	}
+}
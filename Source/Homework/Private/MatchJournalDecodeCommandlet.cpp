@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MatchJournalDecodeCommandlet.h"
+#include "MatchJournal.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+int32 UMatchJournalDecodeCommandlet::Main(const FString& Params)
+{
+	FString InPath;
+	if (!FParse::Value(*Params, TEXT("file="), InPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("MatchJournalDecode needs -file=<journal>"));
+		return 1;
+	}
+	FString OutPath;
+	if (!FParse::Value(*Params, TEXT("out="), OutPath))
+	{
+		OutPath = FPaths::ChangeExtension(InPath, TEXT("csv"));
+	}
+
+	FMatchJournalHeader Header;
+	TArray<FMatchEventRecord> Records;
+	TArray<FMatchJournalName> Names;
+	if (!FMatchJournal::ReadFile(InPath, Header, Records, Names))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s is not a match journal"), *InPath);
+		return 1;
+	}
+
+	// Names are in record order, replay them up to each record so reused ids resolve correctly
+	TMap<uint32, FName> NameById;
+	int32 NextName = 0;
+	auto GetName = [&NameById](uint32 Id)
+	{
+		const FName* Name = NameById.Find(Id);
+		return Name ? Name->ToString() : (Id ? FString::Printf(TEXT("#%u"), Id) : FString());
+	};
+
+	FString Csv = TEXT("Time,Type,Instigator,Target,X,Y,Z,Value,Extra\n");
+	for (int32 Index = 0; Index < Records.Num(); ++Index)
+	{
+		const FMatchEventRecord& Record = Records[Index];
+		for (; NextName < Names.Num() && Names[NextName].Record <= uint64(Index); ++NextName)
+		{
+			NameById.Add(Names[NextName].Id, Names[NextName].Name);
+		}
+		Csv += FString::Printf(TEXT("%.4f,%s,%s,%s,%.1f,%.1f,%.1f,%.2f,%u\n"), Record.Time,
+			FMatchJournal::GetTypeName(Record.Type), *GetName(Record.Instigator), *GetName(Record.Target),
+			Record.X, Record.Y, Record.Z, Record.Value, Record.Extra);
+	}
+	FFileHelper::SaveStringToFile(Csv, *OutPath);
+	UE_LOG(LogTemp, Display, TEXT("Decoded %d records from %s (started %s) to %s"), Records.Num(), *InPath,
+		*FDateTime(Header.StartTicks).ToString(), *OutPath);
+	return 0;
+}
@@ -0,0 +1,159 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MemoryTags.h"
+#include "Containers/Ticker.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectGlobals.h"
+
+LLM_DEFINE_TAG(Homework);
+LLM_DEFINE_TAG(Homework_Weapons);
+LLM_DEFINE_TAG(Homework_AI);
+LLM_DEFINE_TAG(Homework_Grenades);
+LLM_DEFINE_TAG(Homework_Effects);
+LLM_DEFINE_TAG(Homework_UI);
+
+static FAutoConsoleCommandWithOutputDevice MemoryReportCommand(
+	TEXT("Homework.Memory.Report"),
+	TEXT("Print the Homework memory tags, current size and peak for this match. Needs -llm."),
+	FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+	{
+		FMemoryTagReport::Get().Report(Ar);
+	}));
+
+namespace
+{
+	// LLM names the tags after their declaration, underscores become slashes
+	const TCHAR* const GameplayTags[] = {
+		TEXT("Homework/Weapons"),
+		TEXT("Homework/AI"),
+		TEXT("Homework/Grenades"),
+		TEXT("Homework/Effects"),
+		TEXT("Homework/UI"),
+	};
+
+	int64 GetTagAmount(const TCHAR* Tag)
+	{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+		return FLowLevelMemTracker::Get().GetTagAmountForTracker(ELLMTracker::Default, FName(Tag));
+#else
+		return 0;
+#endif
+	}
+
+	bool IsTracking()
+	{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+		return FLowLevelMemTracker::IsEnabled();
+#else
+		return false;
+#endif
+	}
+
+	const TCHAR* GetNetModeName(ENetMode NetMode)
+	{
+		switch (NetMode)
+		{
+		case NM_DedicatedServer:	return TEXT("DedicatedServer");
+		case NM_ListenServer:		return TEXT("ListenServer");
+		case NM_Client:				return TEXT("Client");
+		default:					return TEXT("Standalone");
+		}
+	}
+}
+
+FMemoryTagReport& FMemoryTagReport::Get()
+{
+	static FMemoryTagReport Instance;
+	return Instance;
+}
+
+void FMemoryTagReport::Initialize()
+{
+	if (!IsTracking())
+		return;
+	FCoreUObjectDelegates::PreLoadMap.AddRaw(this, &FMemoryTagReport::OnPreLoadMap);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.AddRaw(this, &FMemoryTagReport::OnPostLoadMap);
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FMemoryTagReport::Sample), 1.0f);
+}
+
+void FMemoryTagReport::Shutdown()
+{
+	if (!IsTracking())
+		return;
+	WriteMatch();
+	FCoreUObjectDelegates::PreLoadMap.RemoveAll(this);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.RemoveAll(this);
+	FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+}
+
+void FMemoryTagReport::OnPreLoadMap(const FString& MapName)
+{
+	// The previous world is still up, last chance to sample it
+	Sample(0.0f);
+	WriteMatch();
+}
+
+void FMemoryTagReport::OnPostLoadMap(UWorld* World)
+{
+	if (!World)
+		return;
+	MatchMap = World->GetMapName();
+	MatchNetMode = GetNetModeName(World->GetNetMode());
+	MatchStartTime = FPlatformTime::Seconds();
+	MatchPeaks.Init(0, UE_ARRAY_COUNT(GameplayTags));
+}
+
+bool FMemoryTagReport::Sample(float DeltaTime)
+{
+	for (int32 i = 0; i < MatchPeaks.Num(); ++i)
+	{
+		MatchPeaks[i] = FMath::Max(MatchPeaks[i], GetTagAmount(GameplayTags[i]));
+	}
+	return true;
+}
+
+void FMemoryTagReport::WriteMatch()
+{
+	if (MatchMap.IsEmpty())
+		return;
+
+	const FString Path = FPaths::ProfilingDir() / TEXT("LLM") / TEXT("HomeworkMatches.csv");
+	FString Row;
+	if (!FPaths::FileExists(Path))
+	{
+		Row = TEXT("Date,Map,NetMode,Seconds");
+		for (const TCHAR* Tag : GameplayTags)
+			Row += FString::Printf(TEXT(",%s KB,%s Peak KB"), Tag, Tag);
+		Row += LINE_TERMINATOR;
+	}
+	Row += FString::Printf(TEXT("%s,%s,%s,%.0f"), *FDateTime::Now().ToString(), *MatchMap, *MatchNetMode,
+		FPlatformTime::Seconds() - MatchStartTime);
+	for (int32 i = 0; i < MatchPeaks.Num(); ++i)
+		Row += FString::Printf(TEXT(",%lld,%lld"), GetTagAmount(GameplayTags[i]) / 1024, MatchPeaks[i] / 1024);
+	Row += LINE_TERMINATOR;
+	FFileHelper::SaveStringToFile(Row, *Path, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(),
+		FILEWRITE_Append);
+
+	UE_LOG(LogTemp, Display, TEXT("Memory tags for %s written to %s"), *MatchMap, *Path);
+	MatchMap.Empty();
+	MatchPeaks.Reset();
+}
+
+void FMemoryTagReport::Report(FOutputDevice& Ar) const
+{
+	if (!IsTracking())
+	{
+		Ar.Logf(TEXT("Memory tags need the -llm command line switch"));
+		return;
+	}
+	for (int32 i = 0; i < UE_ARRAY_COUNT(GameplayTags); ++i)
+	{
+		Ar.Logf(TEXT("%-20s %8lld KB, match peak %8lld KB"), GameplayTags[i], GetTagAmount(GameplayTags[i]) / 1024,
+			MatchPeaks.IsValidIndex(i) ? MatchPeaks[i] / 1024 : 0);
+	}
+}
@@ -2,8 +2,155 @@
 
 
 #include "MultiFPSPlayerController.h"
+#include "Homework.h"
+#include "../HomeworkCharacter.h"
+#include "SpectatorFeed.h"
+#include "ShotTrace.h"
+
+DECLARE_CYCLE_STAT(TEXT("HUD Flush"), STAT_HUDFlush, STATGROUP_Homework);
 
 void AMultiFPSPlayerController::PlayerCameraShake(TSubclassOf<UCameraShakeBase> CameraShake)
 {
 	ClientPlayCameraShake(CameraShake, 1, ECameraShakePlaySpace::CameraLocal, FRotator::ZeroRotator);
 }
+
+void AMultiFPSPlayerController::SetBulletView(int32 ClipCurrBullet, int32 GunCurrBullet)
+{
+	if (HUDView.ClipCurrBullet == ClipCurrBullet && HUDView.GunCurrBullet == GunCurrBullet)
+		return;
+	HUDView.ClipCurrBullet = ClipCurrBullet;
+	HUDView.GunCurrBullet = GunCurrBullet;
+	HUDView.bBulletsDirty = true;
+}
+
+void AMultiFPSPlayerController::SetHPView(int32 CurrHP, float Percent, uint32 ShotId)
+{
+	if (HUDView.CurrHP == CurrHP && HUDView.HPPercent == Percent)
+	{
+		FShotTrace::Get().Record(this, ShotId, EShotStage::VictimHUD);
+		return;
+	}
+	HUDView.CurrHP = CurrHP;
+	HUDView.HPPercent = Percent;
+	HUDView.HPShotId = ShotId;
+	HUDView.bHPDirty = true;
+}
+
+void AMultiFPSPlayerController::AcknowledgePossession(APawn* P)
+{
+	Super::AcknowledgePossession(P);
+	// The owning client learns about the pawn here, possibly before the pawn's Controller replicates
+	if (AHomeworkCharacter* HomeworkCharacter = Cast<AHomeworkCharacter>(P))
+	{
+		HomeworkCharacter->InitializeForController();
+	}
+}
+
+void AMultiFPSPlayerController::ProcessPlayerInput(const float DeltaTime, const bool bGamePaused)
+{
+	Super::ProcessPlayerInput(DeltaTime, bGamePaused);
+	// Touch repeats were only collected by the input stack, turn them into rotation input before
+	// UpdateRotation runs so the camera follows the finger this frame
+	if (AHomeworkCharacter* HomeworkCharacter = Cast<AHomeworkCharacter>(GetPawn()))
+	{
+		HomeworkCharacter->ApplyPendingTouchLook();
+	}
+}
+
+void AMultiFPSPlayerController::PlayerTick(float DeltaTime)
+{
+	Super::PlayerTick(DeltaTime);
+	if (AHomeworkCharacter* HomeworkCharacter = Cast<AHomeworkCharacter>(GetPawn()))
+	{
+		HomeworkCharacter->UpdateTouchLatency();
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_HUDFlush);
+	if (HUDView.bBulletsDirty)
+	{
+		HUDView.bBulletsDirty = false;
+		UpdateBulletUI(HUDView.ClipCurrBullet, HUDView.GunCurrBullet);
+	}
+	if (HUDView.bHPDirty)
+	{
+		HUDView.bHPDirty = false;
+		UpdateHPUI(HUDView.CurrHP, HUDView.HPPercent);
+		FShotTrace::Get().Record(this, HUDView.HPShotId, EShotStage::VictimHUD);
+		HUDView.HPShotId = 0;
+	}
+
+	// Every 2 s while tracing, the fastest of the last pings sets the offset
+	const double Now = FPlatformTime::Seconds();
+	if (FShotTrace::IsEnabled() && GetNetMode() == NM_Client && IsLocalController() && Now - LastShotClockPingTime > 2.0)
+	{
+		LastShotClockPingTime = Now;
+		ServerShotClockPing(Now);
+	}
+}
+
+void AMultiFPSPlayerController::ServerShotClockPing_Implementation(double ClientTime)
+{
+	ClientShotClockPong(ClientTime, FPlatformTime::Seconds());
+}
+
+bool AMultiFPSPlayerController::ServerShotClockPing_Validate(double ClientTime)
+{
+	return true;
+}
+
+void AMultiFPSPlayerController::ClientShotClockPong_Implementation(double ClientTime, double ServerTime)
+{
+	FShotTrace::Get().AddClockSample(ClientTime, ServerTime, FPlatformTime::Seconds());
+}
+
+void AMultiFPSPlayerController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+	StopLowBandwidthSpectating();
+}
+
+void AMultiFPSPlayerController::StartLowBandwidthSpectating(AActor* Target)
+{
+	bLowBandwidthSpectator = true;
+	SpectatedTarget = Target;
+	ASpectatorFeed::FindOrSpawn(GetWorld());
+	if (Target)
+	{
+		SetViewTargetWithBlend(Target, 0.5f);
+	}
+}
+
+void AMultiFPSPlayerController::StopLowBandwidthSpectating()
+{
+	bLowBandwidthSpectator = false;
+	SpectatedTarget.Reset();
+}
+
+void AMultiFPSPlayerController::ServerSpectatePlayer_Implementation(int32 PlayerId)
+{
+	if (!bLowBandwidthSpectator)
+		return;
+	ASpectatorFeed* Feed = ASpectatorFeed::FindOrSpawn(GetWorld());
+	if (AActor* Target = Feed->FindCombatant(uint16(PlayerId)))
+	{
+		StartLowBandwidthSpectating(Target);
+	}
+}
+
+bool AMultiFPSPlayerController::ServerSpectatePlayer_Validate(int32 PlayerId)
+{
+	return PlayerId >= 0 && PlayerId <= MAX_uint16;
+}
+
+bool AMultiFPSPlayerController::IsLowBandwidthSpectator(const AActor* RealViewer)
+{
+	const AMultiFPSPlayerController* PlayerController = Cast<AMultiFPSPlayerController>(RealViewer);
+	return PlayerController && PlayerController->bLowBandwidthSpectator;
+}
+
+bool AMultiFPSPlayerController::IsFilteredForSpectator(const AActor* RealViewer, const AActor* Actor)
+{
+	const AMultiFPSPlayerController* PlayerController = Cast<AMultiFPSPlayerController>(RealViewer);
+	return PlayerController && PlayerController->bLowBandwidthSpectator
+		&& Actor != PlayerController->SpectatedTarget.Get() && Actor != PlayerController->GetPawn();
+}
@@ -4,42 +4,81 @@
 #include "MyUserWidget.h"
 #include "../HomeworkCharacter.h"
 
+typedef void (AHomeworkCharacter::*FTouchActionHandler)();
+
+// Indexed by ETouchAction
+static const FTouchActionHandler PressedHandlers[] =
+{
+	&AHomeworkCharacter::FirePressed,
+	&AHomeworkCharacter::Jump,
+	&AHomeworkCharacter::PitchGrenade,
+	&AHomeworkCharacter::Reload,
+	&AHomeworkCharacter::HighSpeedRunAction,
+	&AHomeworkCharacter::switchForTAction,
+	&AHomeworkCharacter::LockDirection,
+	&AHomeworkCharacter::AimPressed,
+};
+static_assert(UE_ARRAY_COUNT(PressedHandlers) == int32(ETouchAction::Count), "Missing pressed handler");
+
+static const FTouchActionHandler ReleasedHandlers[] =
+{
+	&AHomeworkCharacter::FireReleased,
+	&AHomeworkCharacter::StopJumping,
+	nullptr,
+	nullptr,
+	&AHomeworkCharacter::NormalSpeedWalkAction,
+	nullptr,
+	&AHomeworkCharacter::UnLockDirection,
+	nullptr,
+};
+static_assert(UE_ARRAY_COUNT(ReleasedHandlers) == int32(ETouchAction::Count), "Missing released handler");
+
+static bool FindTouchAction(const FString& Name, ETouchAction& OutAction)
+{
+	static const TMap<FString, ETouchAction> ActionByName = {
+		{TEXT("Fire"), ETouchAction::Fire},
+		{TEXT("Jump"), ETouchAction::Jump},
+		{TEXT("PitchGrenade"), ETouchAction::PitchGrenade},
+		{TEXT("Reload"), ETouchAction::Reload},
+		{TEXT("HighSpeedRun"), ETouchAction::HighSpeedRun},
+		{TEXT("switchForT"), ETouchAction::SwitchForT},
+		{TEXT("ALT"), ETouchAction::LockDirection},
+		{TEXT("Aim"), ETouchAction::Aim}
+	};
+	const ETouchAction* Action = ActionByName.Find(Name);
+	if (!Action)
+		return false;
+	OutAction = *Action;
+	return true;
+}
+
 void UMyUserWidget::SetCurrPawn(AHomeworkCharacter* APlayer)
 {
 	CurPlayer = APlayer;
 }
 
+void UMyUserWidget::ActionPressed(ETouchAction Action)
+{
+	if (CurPlayer && Action < ETouchAction::Count)
+		(CurPlayer->*PressedHandlers[int32(Action)])();
+}
+
+void UMyUserWidget::ActionReleased(ETouchAction Action)
+{
+	if (CurPlayer && Action < ETouchAction::Count && ReleasedHandlers[int32(Action)])
+		(CurPlayer->*ReleasedHandlers[int32(Action)])();
+}
+
 void UMyUserWidget::ButtonClick(FString Name)
 {
-	UE_LOG(LogTemp, Warning, TEXT("FPSCharacter %s"), *Name);
-	if (Name == "Fire")
-		CurPlayer->FirePressed();
-	else if (Name == "Jump")
-		CurPlayer->Jump(); 
-	else if (Name == "PitchGrenade")
-		CurPlayer->PitchGrenade();
-	else if (Name == "Reload")
-		CurPlayer->Reload();
-	else if (Name == "HighSpeedRun")
-		CurPlayer->HighSpeedRunAction();
-	else if (Name == "switchForT")
-		CurPlayer->switchForTAction();
-	else if (Name == "ALT")
-		CurPlayer->LockDirection();
-	else if (Name == "Aim")
-		CurPlayer->AimPressed();
+	ETouchAction Action;
+	if (FindTouchAction(Name, Action))
+		ActionPressed(Action);
 }
 
 void UMyUserWidget::ButtonReleased(FString Name)
 {
-	if (Name == "Fire")
-		CurPlayer->FireReleased();
-	else if (Name == "Jump")
-		CurPlayer->StopJumping();
-	else if (Name == "Jump")
-		CurPlayer->Jump();
-	else if (Name == "HighSpeedRun")
-		CurPlayer->NormalSpeedWalkAction();
-	else if (Name == "ALT")
-		CurPlayer->UnLockDirection();
+	ETouchAction Action;
+	if (FindTouchAction(Name, Action))
+		ActionReleased(Action);
 }
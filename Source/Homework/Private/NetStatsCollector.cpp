@@ -0,0 +1,348 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetStatsCollector.h"
+#include "HomeworkActorChannel.h"
+#include "Async/Async.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/ActorChannel.h"
+#include "GameFramework/Actor.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/CoreNet.h"
+#include "UObject/UnrealType.h"
+
+// Every bunch and RPC goes through the collector while on, so it is opt in
+static TAutoConsoleVariable<int32> CVarNetStatsEnable(
+	TEXT("Homework.NetStats.Enable"),
+	0,
+	TEXT("Record bytes and calls per RPC, replicating actor class and replicated property, per connection."));
+
+static TAutoConsoleVariable<float> CVarNetStatsCsvRollSeconds(
+	TEXT("Homework.NetStats.CsvRollSeconds"),
+	600.0f,
+	TEXT("Start a new NetStats CSV after this many seconds."));
+
+static FAutoConsoleCommandWithOutputDevice NetStatsDumpCommand(
+	TEXT("Homework.NetStats.Dump"),
+	TEXT("Print RPC and actor bandwidth totals sorted by bytes."),
+	FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+	{
+		FNetStatsCollector::Get().DumpReport(Ar);
+	}));
+
+static FAutoConsoleCommand NetStatsResetCommand(
+	TEXT("Homework.NetStats.Reset"),
+	TEXT("Clear the NetStats totals and start a new CSV."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FNetStatsCollector::Get().Reset();
+	}));
+
+static const TCHAR* GetKindName(ENetStatsKind Kind)
+{
+	switch (Kind)
+	{
+	case ENetStatsKind::RPC:
+		return TEXT("RPC");
+	case ENetStatsKind::Actor:
+		return TEXT("Actor");
+	default:
+		return TEXT("Property");
+	}
+}
+
+// Whether a property with this condition goes to a connection, from what the channel knows of it
+static bool IsSentTo(ELifetimeCondition Condition, bool bInitial, bool bOwner)
+{
+	switch (Condition)
+	{
+	case COND_InitialOnly:
+		return bInitial;
+	case COND_OwnerOnly:
+	case COND_AutonomousOnly:
+		return bOwner;
+	case COND_SkipOwner:
+	case COND_SimulatedOnly:
+	case COND_SimulatedOrPhysics:
+	case COND_SimulatedOnlyNoReplay:
+	case COND_SimulatedOrPhysicsNoReplay:
+		return !bOwner;
+	case COND_InitialOrOwner:
+		return bInitial || bOwner;
+	case COND_ReplayOrOwner:
+		return bOwner;
+	case COND_ReplayOnly:
+	case COND_Never:
+		return false;
+	default:
+		return true;
+	}
+}
+
+// Structs without a native NetSerialize and arrays are written field by field and element by
+// element, as the rep layout does; calling NetSerializeItem on them is fatal
+static void SerializeForStats(FProperty* Property, void* Value, FNetBitWriter& Writer)
+{
+	if (FArrayProperty* ArrayProperty = CastField<FArrayProperty>(Property))
+	{
+		FScriptArrayHelper Array(ArrayProperty, Value);
+		uint16 Num = uint16(FMath::Min(Array.Num(), 0xFFFF));
+		Writer << Num;
+		for (int32 i = 0; i < Num; ++i)
+			SerializeForStats(ArrayProperty->Inner, Array.GetRawPtr(i), Writer);
+		return;
+	}
+	if (FStructProperty* StructProperty = CastField<FStructProperty>(Property))
+	{
+		if (!(StructProperty->Struct->StructFlags & STRUCT_NetSerializeNative))
+		{
+			for (TFieldIterator<FProperty> It(StructProperty->Struct); It; ++It)
+			{
+				if (It->HasAnyPropertyFlags(CPF_RepSkip))
+					continue;
+				for (int32 i = 0; i < It->ArrayDim; ++i)
+					SerializeForStats(*It, It->ContainerPtrToValuePtr<void>(Value, i), Writer);
+			}
+			return;
+		}
+	}
+	Property->NetSerializeItem(Writer, Writer.PackageMap, Value);
+}
+
+FNetStatsCollector& FNetStatsCollector::Get()
+{
+	static FNetStatsCollector Instance;
+	return Instance;
+}
+
+bool FNetStatsCollector::IsEnabled()
+{
+	return CVarNetStatsEnable.GetValueOnGameThread() != 0;
+}
+
+int32 FNetStatsCollector::GetConnectionId(const UNetConnection* Connection)
+{
+	if (const int32* Id = ConnectionIds.Find(Connection))
+		return *Id;
+	const int32 Id = Connections.Add(Connection);
+	ConnectionNames.AddDefaulted();
+	ConnectionIds.Add(Connection, Id);
+	return Id;
+}
+
+const FString& FNetStatsCollector::GetConnectionName(int32 Id)
+{
+	FString& Name = ConnectionNames[Id];
+	if (Name.IsEmpty())
+	{
+		const UNetConnection* Connection = Connections[Id].Get();
+		// Closed before anything of it was written, the id still tells its rows apart
+		Name = Connection ? Connection->LowLevelGetRemoteAddress(true) : FString::Printf(TEXT("Closed%d"), Id);
+	}
+	return Name;
+}
+
+const TArray<FNetStatsCollector::FRepProperty>& FNetStatsCollector::GetRepProperties(UClass* Class)
+{
+	if (const TArray<FRepProperty>* Found = RepProperties.Find(Class))
+		return *Found;
+
+	TArray<FRepProperty>& Properties = RepProperties.Add(Class);
+	TArray<FLifetimeProperty> LifetimeProperties;
+	Class->GetDefaultObject()->GetLifetimeReplicatedProps(LifetimeProperties);
+	for (const FLifetimeProperty& Lifetime : LifetimeProperties)
+	{
+		if (!Class->ClassReps.IsValidIndex(Lifetime.RepIndex))
+			continue;
+		const FRepRecord& Record = Class->ClassReps[Lifetime.RepIndex];
+		Properties.Add({ Record.Property, Record.Index, Lifetime.Condition,
+			FName(*FString::Printf(TEXT("%s.%s"), *Class->GetName(), *Record.Property->GetName())) });
+	}
+	return Properties;
+}
+
+void FNetStatsCollector::Record(const UNetConnection* Connection, ENetStatsKind Kind, FName Name, int64 Bits)
+{
+	const double Now = FPlatformTime::Seconds();
+	if (SecondStartTime == 0.0)
+	{
+		SecondStartTime = Now;
+	}
+	else if (Now - SecondStartTime >= 1.0)
+	{
+		RollSecond(Now);
+	}
+
+	FNetStatsEntry& Entry = CurrentSecond.FindOrAdd(FKey{ GetConnectionId(Connection), Kind, Name });
+	Entry.Bits += Bits;
+	Entry.Count += 1;
+}
+
+void FNetStatsCollector::RecordActorBunch(const UNetConnection* Connection, const AActor* Actor, int64 Bits,
+	FNetStatsPropertyShadows& Shadows)
+{
+	if (RPCScopeDepth > 0 || !IsEnabled() || !Actor)
+		return;
+	Record(Connection, ENetStatsKind::Actor, Actor->GetClass()->GetFName(), Bits);
+	RecordProperties(Connection, Actor, Shadows);
+}
+
+void FNetStatsCollector::RecordProperties(const UNetConnection* Connection, const AActor* Actor,
+	FNetStatsPropertyShadows& Shadows)
+{
+	const TArray<FRepProperty>& Properties = GetRepProperties(Actor->GetClass());
+	const bool bInitial = !Shadows.bInitialized;
+	if (bInitial)
+	{
+		Shadows.Values.SetNum(Properties.Num());
+		Shadows.bInitialized = true;
+	}
+	const bool bOwner = Actor->GetNetConnection() == Connection;
+
+	// Compared against what this connection was last sent, a value that did not change was not in the bunch
+	FNetBitWriter Writer(GetMutableDefault<UNetStatsPackageMap>(), 0);
+	for (int32 Index = 0; Index < Properties.Num(); ++Index)
+	{
+		const FRepProperty& Rep = Properties[Index];
+		if (!IsSentTo(Rep.Condition, bInitial, bOwner))
+			continue;
+		Writer.Reset();
+		SerializeForStats(Rep.Property, Rep.Property->ContainerPtrToValuePtr<void>(const_cast<AActor*>(Actor), Rep.ArrayIndex),
+			Writer);
+
+		FNetStatsPropertyShadows::FValue& Shadow = Shadows.Values[Index];
+		const int64 NumBytes = Writer.GetNumBytes();
+		if (Shadow.NumBits == Writer.GetNumBits() && FMemory::Memcmp(Shadow.Bytes.GetData(), Writer.GetData(), NumBytes) == 0)
+			continue;
+		Shadow.Bytes.SetNumUninitialized(NumBytes);
+		FMemory::Memcpy(Shadow.Bytes.GetData(), Writer.GetData(), NumBytes);
+		Shadow.NumBits = Writer.GetNumBits();
+		Record(Connection, ENetStatsKind::Property, Rep.StatName, Writer.GetNumBits());
+	}
+}
+
+void FNetStatsCollector::RollSecond(double Now)
+{
+	if (CurrentSecond.Num() > 0)
+	{
+		WriteCsv(CurrentSecond, SecondIndex);
+		for (const TPair<FKey, FNetStatsEntry>& Pair : CurrentSecond)
+		{
+			FNetStatsEntry& Total = Totals.FindOrAdd(Pair.Key);
+			Total.Bits += Pair.Value.Bits;
+			Total.Count += Pair.Value.Count;
+		}
+		CurrentSecond.Reset();
+	}
+	const int64 Elapsed = int64(Now - SecondStartTime);
+	SecondIndex += Elapsed;
+	SecondStartTime += double(Elapsed);
+}
+
+void FNetStatsCollector::WriteCsv(const TMap<FKey, FNetStatsEntry>& Bucket, int64 Second)
+{
+	const double Now = FPlatformTime::Seconds();
+	FString Lines;
+	if (CsvPath.IsEmpty() || Now - CsvStartTime >= CVarNetStatsCsvRollSeconds.GetValueOnGameThread())
+	{
+		CsvStartTime = Now;
+		CsvPath = FPaths::ProfilingDir() / TEXT("NetStats") /
+			FString::Printf(TEXT("NetStats-%s.csv"), *FDateTime::Now().ToString());
+		Lines = TEXT("Second,Connection,Kind,Name,Count,Bytes\n");
+	}
+	for (const TPair<FKey, FNetStatsEntry>& Pair : Bucket)
+	{
+		Lines += FString::Printf(TEXT("%lld,%s,%s,%s,%d,%lld\n"), Second, *GetConnectionName(Pair.Key.Connection),
+			GetKindName(Pair.Key.Kind), *Pair.Key.Name.ToString(), Pair.Value.Count, (Pair.Value.Bits + 7) / 8);
+	}
+
+	// The file is written on a worker, the game thread only formats the lines
+	if (PendingCsvWrite.IsValid())
+	{
+		PendingCsvWrite.Wait();
+	}
+	PendingCsvWrite = Async(EAsyncExecution::ThreadPool, [Path = CsvPath, Lines = MoveTemp(Lines)]()
+	{
+		FFileHelper::SaveStringToFile(Lines, *Path, FFileHelper::EEncodingOptions::AutoDetect,
+			&IFileManager::Get(), FILEWRITE_Append);
+	});
+}
+
+void FNetStatsCollector::DumpReport(FOutputDevice& Ar)
+{
+	if (SecondStartTime > 0.0)
+	{
+		RollSecond(FPlatformTime::Seconds());
+	}
+
+	TArray<TPair<FKey, FNetStatsEntry>> Sorted = Totals.Array();
+	Sorted.Sort([](const TPair<FKey, FNetStatsEntry>& A, const TPair<FKey, FNetStatsEntry>& B)
+	{
+		return A.Value.Bits > B.Value.Bits;
+	});
+
+	const double Seconds = FMath::Max<double>(SecondIndex, 1.0);
+	Ar.Logf(TEXT("NetStats over %lld s"), SecondIndex);
+	Ar.Logf(TEXT("%-24s %-8s %-32s %10s %12s %10s"), TEXT("Connection"), TEXT("Kind"), TEXT("Name"),
+		TEXT("Count"), TEXT("Bytes"), TEXT("Bytes/s"));
+	for (const TPair<FKey, FNetStatsEntry>& Pair : Sorted)
+	{
+		const int64 Bytes = (Pair.Value.Bits + 7) / 8;
+		Ar.Logf(TEXT("%-24s %-8s %-32s %10d %12lld %10.1f"), *GetConnectionName(Pair.Key.Connection),
+			GetKindName(Pair.Key.Kind), *Pair.Key.Name.ToString(), Pair.Value.Count, Bytes, Bytes / Seconds);
+	}
+}
+
+void FNetStatsCollector::Reset()
+{
+	CurrentSecond.Reset();
+	Totals.Reset();
+	SecondStartTime = 0.0;
+	SecondIndex = 0;
+	CsvPath.Empty();
+}
+
+FNetStatsRPCScope::FNetStatsRPCScope(AActor* Actor, UFunction* Function)
+{
+	if (!FNetStatsCollector::IsEnabled() || !Actor || !Function)
+		return;
+	UNetDriver* NetDriver = Actor->GetNetDriver();
+	if (!NetDriver)
+		return;
+
+	FunctionName = Function->GetFName();
+	++FNetStatsCollector::Get().RPCScopeDepth;
+	bCounted = true;
+	auto AddSnapshot = [this](UNetConnection* Connection)
+	{
+		if (Connection)
+		{
+			Snapshots.Add({ Connection, Connection->SendBuffer.GetNumBits(), Connection->OutTotalBytes });
+		}
+	};
+	AddSnapshot(NetDriver->ServerConnection);
+	for (UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		AddSnapshot(Connection);
+	}
+}
+
+FNetStatsRPCScope::~FNetStatsRPCScope()
+{
+	if (bCounted)
+		--FNetStatsCollector::Get().RPCScopeDepth;
+	for (const FConnectionSnapshot& Snapshot : Snapshots)
+	{
+		// A flush inside the call moves buffered bits into OutTotalBytes, count both
+		const int64 Bits = (Snapshot.Connection->OutTotalBytes - Snapshot.TotalBytes) * 8
+			+ Snapshot.Connection->SendBuffer.GetNumBits() - Snapshot.BufferedBits;
+		if (Bits > 0)
+		{
+			FNetStatsCollector::Get().Record(Snapshot.Connection, ENetStatsKind::RPC, FunctionName, Bits);
+		}
+	}
+}
@@ -0,0 +1,222 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetUpdateManager.h"
+#include "Homework.h"
+#include "../HomeworkCharacter.h"
+#include "AICharacter.h"
+#include "WeaponBaseServer.h"
+#include "Engine/Engine.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "TimerManager.h"
+
+static TAutoConsoleVariable<int32> CVarNetUpdateAdaptive(
+	TEXT("Homework.NetUpdate.Enable"),
+	1,
+	TEXT("Adapt the net update frequency of characters and weapons. 0 restores the class defaults, for A/B runs."));
+
+// Compare OutBytesPerSecond with Homework.NetUpdate.Enable 0 and 1 on the same session
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice CmdNetUpdateStats(
+	TEXT("Homework.NetUpdate.Stats"),
+	TEXT("Prints the adaptive net update rates and the outgoing bandwidth of each connection."),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		if (const UNetUpdateManager* Manager = World ? World->GetSubsystem<UNetUpdateManager>() : nullptr)
+		{
+			Manager->Report(Ar);
+		}
+	}));
+
+UNetUpdateManager::UNetUpdateManager()
+{
+	NearDistance = 1500.0f;
+	FarDistance = 8000.0f;
+	// The snapshot buffer of simulated proxies is tuned for 10 Hz
+	MinFrequency = 10.0f;
+	MovingMinFrequency = 15.0f;
+	CombatMinFrequency = 50.0f;
+	CombatHoldTime = 3.0f;
+	MinLoadScale = 0.5f;
+}
+
+bool UNetUpdateManager::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void UNetUpdateManager::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+	const ENetMode NetMode = InWorld.GetNetMode();
+	if (NetMode == NM_DedicatedServer || NetMode == NM_ListenServer)
+	{
+		InWorld.GetTimerManager().SetTimer(UpdateTimer, FTimerDelegate::CreateUObject(this, &UNetUpdateManager::UpdateActors),
+			1.0f, true);
+	}
+}
+
+void UNetUpdateManager::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(UpdateTimer);
+	}
+	Super::Deinitialize();
+}
+
+void UNetUpdateManager::NotifyCombat(AActor* Actor)
+{
+	UWorld* World = Actor ? Actor->GetWorld() : nullptr;
+	UNetUpdateManager* Manager = World ? World->GetSubsystem<UNetUpdateManager>() : nullptr;
+	if (!Manager || !Actor->HasAuthority())
+		return;
+	Manager->LastCombatTime.Add(Actor, World->GetTimeSeconds());
+	// Don't wait for the next pass to catch up
+	const float CombatFrequency = FMath::Min(Manager->CombatMinFrequency, Actor->GetClass()->GetDefaultObject<AActor>()->NetUpdateFrequency);
+	if (Manager->bApplied && Actor->NetUpdateFrequency < CombatFrequency)
+	{
+		Manager->ApplyRate(Actor, CombatFrequency, Actor->NetPriority);
+	}
+}
+
+bool UNetUpdateManager::IsInCombat(const AActor* Actor, float Now) const
+{
+	const float* Time = LastCombatTime.Find(Actor);
+	return Time && Now - *Time < CombatHoldTime;
+}
+
+void UNetUpdateManager::ApplyRate(AActor* Actor, float Frequency, float Priority)
+{
+	const AActor* Default = Actor->GetClass()->GetDefaultObject<AActor>();
+	const bool bRaised = Frequency > Actor->NetUpdateFrequency + 1.0f;
+	Actor->NetUpdateFrequency = Frequency;
+	Actor->MinNetUpdateFrequency = FMath::Min(Default->MinNetUpdateFrequency, Frequency);
+	Actor->NetPriority = Priority;
+	if (bRaised)
+	{
+		Actor->ForceNetUpdate();
+	}
+}
+
+void UNetUpdateManager::RestoreDefaults()
+{
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		if (It->IsA<ACharacter>() || It->IsA<AWeaponBaseServer>())
+		{
+			const AActor* Default = It->GetClass()->GetDefaultObject<AActor>();
+			ApplyRate(*It, Default->NetUpdateFrequency, Default->NetPriority);
+		}
+	}
+	bApplied = false;
+}
+
+void UNetUpdateManager::UpdateActors()
+{
+	UWorld* World = GetWorld();
+	UNetDriver* NetDriver = World->GetNetDriver();
+	if (!CVarNetUpdateAdaptive.GetValueOnGameThread() || !NetDriver)
+	{
+		if (bApplied)
+			RestoreDefaults();
+		return;
+	}
+
+	const float Now = World->GetTimeSeconds();
+	for (auto It = LastCombatTime.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid() || Now - It.Value() >= CombatHoldTime)
+			It.RemoveCurrent();
+	}
+
+	struct FViewer
+	{
+		FVector Location;
+		const AActor* Pawn;
+		const AActor* ViewTarget;
+	};
+	TArray<FViewer, TInlineAllocator<16>> Viewers;
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (APlayerController* PlayerController = It->Get())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			Viewers.Add({ ViewLocation, PlayerController->GetPawn(), PlayerController->GetViewTarget() });
+		}
+	}
+
+	// Only idle actors pay for a server running behind its tick rate
+	const float FrameBudgetMs = 1000.0f / FMath::Max(NetDriver->NetServerMaxTickRate, 1);
+	LoadScale = FMath::Clamp(FrameBudgetMs / FMath::Max(GAverageMS, 1.0f), MinLoadScale, 1.0f);
+
+	NumActors = 0;
+	NumCombat = 0;
+	float TotalFrequency = 0.0f;
+	float TotalDefaultFrequency = 0.0f;
+	auto UpdateActor = [&](AActor* Actor, const AActor* CombatActor)
+	{
+		const AActor* Default = Actor->GetClass()->GetDefaultObject<AActor>();
+		// A viewer is always next to its own pawn and weapon, they're rated by the other viewers
+		float MinDistSquared = FMath::Square(FarDistance);
+		for (const FViewer& Viewer : Viewers)
+		{
+			if (Viewer.Pawn == CombatActor || Viewer.ViewTarget == CombatActor)
+				continue;
+			MinDistSquared = FMath::Min(MinDistSquared, FVector::DistSquared(Viewer.Location, Actor->GetActorLocation()));
+		}
+		const float Alpha = FMath::Clamp(FMath::GetRangePct(NearDistance, FarDistance, FMath::Sqrt(MinDistSquared)), 0.0f, 1.0f);
+
+		float Frequency = FMath::Lerp(Default->NetUpdateFrequency, MinFrequency, Alpha);
+		if (!CombatActor->GetVelocity().IsNearlyZero(10.0f))
+			Frequency = FMath::Max(Frequency, MovingMinFrequency);
+		Frequency = FMath::Max(Frequency * LoadScale, MinFrequency);
+		float Priority = Default->NetPriority * FMath::Lerp(1.0f, 0.5f, Alpha);
+		if (IsInCombat(CombatActor, Now))
+		{
+			Frequency = FMath::Max(Frequency, CombatMinFrequency);
+			Priority = Default->NetPriority * 1.5f;
+			++NumCombat;
+		}
+		Frequency = FMath::Min(Frequency, Default->NetUpdateFrequency);
+
+		ApplyRate(Actor, Frequency, Priority);
+		++NumActors;
+		TotalFrequency += Frequency;
+		TotalDefaultFrequency += Default->NetUpdateFrequency;
+	};
+
+	for (TActorIterator<ACharacter> It(World); It; ++It)
+	{
+		if (It->IsA<AHomeworkCharacter>() || It->IsA<AAICharacter>())
+			UpdateActor(*It, *It);
+	}
+	// Held weapons follow their holder's activity
+	for (TActorIterator<AWeaponBaseServer> It(World); It; ++It)
+	{
+		UpdateActor(*It, It->GetOwner() ? It->GetOwner() : *It);
+	}
+
+	AverageFrequency = NumActors > 0 ? TotalFrequency / NumActors : 0.0f;
+	AverageDefaultFrequency = NumActors > 0 ? TotalDefaultFrequency / NumActors : 0.0f;
+	bApplied = true;
+}
+
+void UNetUpdateManager::Report(FOutputDevice& Ar) const
+{
+	Ar.Logf(TEXT("Adaptive net update %s: %d actors, %d in combat, %.1f Hz average (defaults %.1f Hz), load scale %.2f"),
+		bApplied ? TEXT("on") : TEXT("off"), NumActors, NumCombat, AverageFrequency, AverageDefaultFrequency, LoadScale);
+	if (const UNetDriver* NetDriver = GetWorld()->GetNetDriver())
+	{
+		for (const UNetConnection* Connection : NetDriver->ClientConnections)
+		{
+			Ar.Logf(TEXT("  %s: %d bytes/s out, %d bytes/s in"), *Connection->LowLevelGetRemoteAddress(),
+				Connection->OutBytesPerSecond, Connection->InBytesPerSecond);
+		}
+	}
+}
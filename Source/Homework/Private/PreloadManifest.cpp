@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PreloadManifest.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "UObject/UObjectGlobals.h"
+
+static TAutoConsoleVariable<int32> CVarPreloadManifest(
+	TEXT("Homework.Preload.Enable"),
+	1,
+	TEXT("Stream the preload manifest while the first map loads."));
+
+static FAutoConsoleCommandWithOutputDevice PreloadReportCommand(
+	TEXT("Homework.Preload.Report"),
+	TEXT("Print the time to playable and the first use hitches seen so far."),
+	FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+	{
+		FPreloadTimeline::Get().Report(Ar);
+	}));
+
+UPreloadManifest::UPreloadManifest()
+{
+	SourcePaths.Add(TEXT("/Game/BluePrint/weapon"));
+}
+
+FPreloadTimeline& FPreloadTimeline::Get()
+{
+	static FPreloadTimeline Instance;
+	return Instance;
+}
+
+void FPreloadTimeline::Initialize()
+{
+	FCoreUObjectDelegates::PreLoadMap.AddRaw(this, &FPreloadTimeline::OnPreLoadMap);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.AddRaw(this, &FPreloadTimeline::OnPostLoadMap);
+	FCoreDelegates::OnSyncLoadPackage.AddRaw(this, &FPreloadTimeline::OnSyncLoadPackage);
+}
+
+void FPreloadTimeline::Shutdown()
+{
+	FCoreUObjectDelegates::PreLoadMap.RemoveAll(this);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.RemoveAll(this);
+	FCoreDelegates::OnSyncLoadPackage.RemoveAll(this);
+	Handle.Reset();
+}
+
+void FPreloadTimeline::AddEvent(const FString& Event)
+{
+	Events.Emplace(FPlatformTime::Seconds() - GStartTime, Event);
+}
+
+void FPreloadTimeline::OnPreLoadMap(const FString& MapName)
+{
+	MapLoadStartTime = FPlatformTime::Seconds();
+	bPlayable = false;
+	AddEvent(FString::Printf(TEXT("Load map %s"), *MapName));
+
+	// Streamed once and kept for the session, the weapons are the same on every map
+	const UPreloadManifest* Manifest = GetDefault<UPreloadManifest>();
+	if (Handle.IsValid() || Manifest->Assets.Num() == 0 || !CVarPreloadManifest.GetValueOnGameThread()
+		|| IsRunningDedicatedServer())
+		return;
+	ManifestStartTime = FPlatformTime::Seconds();
+	Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Manifest->Assets,
+		FStreamableDelegate::CreateRaw(this, &FPreloadTimeline::OnManifestLoaded), FStreamableManager::AsyncLoadHighPriority);
+}
+
+void FPreloadTimeline::OnPostLoadMap(UWorld* World)
+{
+	AddEvent(FString::Printf(TEXT("Map loaded in %.0f ms"), (FPlatformTime::Seconds() - MapLoadStartTime) * 1000.0));
+}
+
+void FPreloadTimeline::OnManifestLoaded()
+{
+	AddEvent(FString::Printf(TEXT("Preload manifest, %d assets in %.0f ms"), GetDefault<UPreloadManifest>()->Assets.Num(),
+		(FPlatformTime::Seconds() - ManifestStartTime) * 1000.0));
+}
+
+void FPreloadTimeline::MarkPlayable()
+{
+	if (bPlayable)
+		return;
+	bPlayable = true;
+	AddEvent(FString::Printf(TEXT("Playable, %.0f ms after the map load started%s"),
+		(FPlatformTime::Seconds() - MapLoadStartTime) * 1000.0,
+		Handle.IsValid() && !Handle->HasLoadCompleted() ? TEXT(", manifest still streaming") : TEXT("")));
+	Report(*GLog);
+}
+
+void FPreloadTimeline::OnSyncLoadPackage(const FString& PackageName)
+{
+	// Anything loaded synchronously once playable is a hitch the manifest missed
+	if (bPlayable)
+		AddEvent(FString::Printf(TEXT("Sync load %s"), *PackageName));
+}
+
+void FPreloadTimeline::RecordFirstUse(FName Action, double Seconds)
+{
+	UsedActions.Add(Action);
+	AddEvent(FString::Printf(TEXT("First %s took %.2f ms"), *Action.ToString(), Seconds * 1000.0));
+}
+
+void FPreloadTimeline::Report(FOutputDevice& Ar) const
+{
+	for (const TPair<double, FString>& Event : Events)
+	{
+		Ar.Logf(TEXT("[%8.3f] %s"), Event.Key, *Event.Value);
+	}
+}
+
+FPreloadFirstUseScope::FPreloadFirstUseScope(FName InAction)
+	: Action(InAction)
+	, StartTime(FPreloadTimeline::Get().HasUsed(InAction) ? 0.0 : FPlatformTime::Seconds())
+{
+}
+
+FPreloadFirstUseScope::~FPreloadFirstUseScope()
+{
+	if (StartTime > 0.0)
+		FPreloadTimeline::Get().RecordFirstUse(Action, FPlatformTime::Seconds() - StartTime);
+}
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PreloadManifestCommandlet.h"
+#include "PreloadManifest.h"
+#include "Grenade.h"
+#include "WeaponBaseClient.h"
+#include "WeaponBaseServer.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Engine/Blueprint.h"
+
+int32 UPreloadManifestCommandlet::Main(const FString& Params)
+{
+	UPreloadManifest* Manifest = GetMutableDefault<UPreloadManifest>();
+	const TArray<FSoftObjectPath> Assets = Collect();
+	if (FParse::Param(*Params, TEXT("check")))
+	{
+		if (Assets != Manifest->Assets)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Preload manifest is stale: %d assets committed, %d needed. Run -run=PreloadManifest and commit DefaultGame.ini"),
+				Manifest->Assets.Num(), Assets.Num());
+			return 1;
+		}
+		UE_LOG(LogTemp, Display, TEXT("Preload manifest is up to date, %d assets"), Assets.Num());
+		return 0;
+	}
+
+	Manifest->Assets = Assets;
+	Manifest->UpdateDefaultConfigFile();
+	return 0;
+}
+
+TArray<FSoftObjectPath> UPreloadManifestCommandlet::Collect()
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	const UPreloadManifest* Manifest = GetDefault<UPreloadManifest>();
+	FARFilter Filter;
+	Filter.ClassNames.Add(UBlueprint::StaticClass()->GetFName());
+	Filter.bRecursivePaths = true;
+	for (const FString& Path : Manifest->SourcePaths)
+	{
+		Filter.PackagePaths.Add(*Path);
+	}
+	TArray<FAssetData> Blueprints;
+	AssetRegistry.GetAssets(Filter, Blueprints);
+
+	// Every game package the weapon blueprints pull in: meshes, materials, sounds, particles, widgets
+	TArray<FName> Pending;
+	TSet<FName> Packages;
+	for (const FAssetData& Asset : Blueprints)
+	{
+		const UBlueprint* Blueprint = Cast<UBlueprint>(Asset.GetAsset());
+		const UClass* GeneratedClass = Blueprint ? Blueprint->GeneratedClass : nullptr;
+		if (GeneratedClass && (GeneratedClass->IsChildOf<AWeaponBaseServer>() || GeneratedClass->IsChildOf<AWeaponBaseClient>()
+			|| GeneratedClass->IsChildOf<AGrenade>()))
+		{
+			Pending.Add(Asset.PackageName);
+		}
+	}
+	while (Pending.Num() > 0)
+	{
+		const FName PackageName = Pending.Pop(false);
+		if (Packages.Contains(PackageName) || !PackageName.ToString().StartsWith(TEXT("/Game/")))
+			continue;
+		Packages.Add(PackageName);
+		TArray<FName> Dependencies;
+		AssetRegistry.GetDependencies(PackageName, Dependencies, UE::AssetRegistry::EDependencyCategory::Package,
+			UE::AssetRegistry::EDependencyQuery::Hard);
+		Pending.Append(Dependencies);
+	}
+
+	TArray<FSoftObjectPath> Result;
+	for (const FName& PackageName : Packages)
+	{
+		TArray<FAssetData> Assets;
+		AssetRegistry.GetAssetsByPackageName(PackageName, Assets);
+		for (const FAssetData& Asset : Assets)
+		{
+			Result.Add(Asset.ToSoftObjectPath());
+		}
+	}
+	Result.Sort([](const FSoftObjectPath& A, const FSoftObjectPath& B) { return A.ToString() < B.ToString(); });
+
+	UE_LOG(LogTemp, Display, TEXT("Preload manifest: %d assets from %d packages, %d blueprints scanned"),
+		Result.Num(), Packages.Num(), Blueprints.Num());
+	return Result;
+}
@@ -0,0 +1,236 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PropPhysicsManager.h"
+#include "Homework.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Pawn.h"
+#include "WeaponBaseServer.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Prop Impulse Bodies"), STAT_PropImpulseBodies, STATGROUP_Homework);
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice CmdPropsStats(
+	TEXT("Homework.Props.Stats"),
+	TEXT("Prints the simulated props the server replicates, how many are awake and how many impulses were merged."),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		if (const UPropPhysicsManager* Manager = World ? World->GetSubsystem<UPropPhysicsManager>() : nullptr)
+		{
+			Manager->Report(Ar);
+		}
+	}));
+
+const FName UPropPhysicsManager::PropTag(TEXT("Prop"));
+
+UPropPhysicsManager::UPropPhysicsManager()
+{
+	AwakeNetUpdateFrequency = 30.0f;
+}
+
+bool UPropPhysicsManager::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void UPropPhysicsManager::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+	if (InWorld.GetNetMode() == NM_Client)
+		return;
+	for (TActorIterator<AActor> It(&InWorld); It; ++It)
+	{
+		if (IsProp(*It))
+			RegisterProp(*It);
+	}
+}
+
+bool UPropPhysicsManager::IsProp(const AActor* Actor)
+{
+	// Weapons simulate while lying around but stop when picked up, they are never props
+	const UPrimitiveComponent* Root = Actor ? Cast<UPrimitiveComponent>(Actor->GetRootComponent()) : nullptr;
+	return Root && Root->IsSimulatingPhysics() && (Actor->GetIsReplicated() || Actor->ActorHasTag(PropTag))
+		&& !Actor->IsA<APawn>() && !Actor->IsA<AWeaponBaseServer>();
+}
+
+void UPropPhysicsManager::Deinitialize()
+{
+	Pending.Reset();
+	Props.Reset();
+	Super::Deinitialize();
+}
+
+void UPropPhysicsManager::Tick(float DeltaTime)
+{
+	// One push per body, whatever number of pellets and explosion rays hit it this frame
+	SET_DWORD_STAT(STAT_PropImpulseBodies, Pending.Num());
+	for (const auto& Entry : Pending)
+	{
+		UPrimitiveComponent* Component = Entry.Key.Get();
+		if (Component && Component->IsSimulatingPhysics())
+		{
+			Component->AddImpulse(Entry.Value.Linear);
+			Component->AddAngularImpulseInRadians(Entry.Value.Angular);
+			++NumApplied;
+		}
+	}
+	Pending.Reset();
+}
+
+ETickableTickType UPropPhysicsManager::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UPropPhysicsManager::IsTickable() const
+{
+	return Pending.Num() > 0;
+}
+
+TStatId UPropPhysicsManager::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPropPhysicsManager, STATGROUP_Tickables);
+}
+
+UWorld* UPropPhysicsManager::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void UPropPhysicsManager::AddImpulseAtLocation(UPrimitiveComponent* Component, const FVector& Impulse,
+	const FVector& Location)
+{
+	UWorld* World = Component ? Component->GetWorld() : nullptr;
+	UPropPhysicsManager* Manager = World ? World->GetSubsystem<UPropPhysicsManager>() : nullptr;
+	if (!Manager)
+		return;
+
+	AActor* Owner = Component->GetOwner();
+	const bool bClient = World->GetNetMode() == NM_Client;
+	const bool bRoot = Owner && Owner->GetRootComponent() == Component;
+	if (!Component->IsSimulatingPhysics())
+	{
+		if (bRoot && !bClient)
+			Manager->UnregisterProp(Owner);
+		return;
+	}
+	if (bRoot && IsProp(Owner))
+	{
+		// Clients follow the server's body, anything else only simulates locally and is pushed on every machine
+		if (bClient)
+			return;
+		if (!Manager->Props.Contains(Owner))
+			Manager->RegisterProp(Owner);
+	}
+
+	// Impulses at a point add up to one linear and one angular impulse about the center of mass
+	FPendingImpulse& Entry = Manager->Pending.FindOrAdd(Component);
+	Entry.Linear += Impulse;
+	Entry.Angular += (Location - Component->GetCenterOfMass()) ^ Impulse;
+	++Manager->NumImpulses;
+}
+
+void UPropPhysicsManager::RegisterProp(AActor* Actor)
+{
+	UPrimitiveComponent* Root = CastChecked<UPrimitiveComponent>(Actor->GetRootComponent());
+	FRepMovement& RepMovement = Actor->GetReplicatedMovement_Mutable();
+	Props.Add(Actor, { Actor->NetUpdateFrequency, Actor->IsReplicatingMovement(), RepMovement.LocationQuantizationLevel,
+		RepMovement.VelocityQuantizationLevel, RepMovement.RotationQuantizationLevel });
+
+	// Clients follow the server's body instead of simulating their own pushes
+	if (!Actor->GetIsReplicated())
+		Actor->SetReplicates(true);
+	Actor->SetReplicateMovement(true);
+	RepMovement.LocationQuantizationLevel = EVectorQuantization::RoundWholeNumber;
+	RepMovement.VelocityQuantizationLevel = EVectorQuantization::RoundWholeNumber;
+	RepMovement.RotationQuantizationLevel = ERotatorQuantization::ByteComponents;
+	Actor->NetUpdateFrequency = AwakeNetUpdateFrequency;
+
+	// Dormant while asleep, the last update before that carries the resting state
+	if (!Root->BodyInstance.bGenerateWakeEvents)
+	{
+		Root->BodyInstance.bGenerateWakeEvents = true;
+		Root->RecreatePhysicsState();
+	}
+	Root->OnComponentWake.AddDynamic(this, &UPropPhysicsManager::OnPropWake);
+	Root->OnComponentSleep.AddDynamic(this, &UPropPhysicsManager::OnPropSleep);
+	if (Root->RigidBodyIsAwake())
+	{
+		Actor->SetNetDormancy(DORM_Awake);
+		++NumAwake;
+	}
+	else
+	{
+		Actor->SetNetDormancy(DORM_DormantAll);
+	}
+}
+
+void UPropPhysicsManager::Unregister(AActor* Actor)
+{
+	UWorld* World = Actor ? Actor->GetWorld() : nullptr;
+	if (UPropPhysicsManager* Manager = World ? World->GetSubsystem<UPropPhysicsManager>() : nullptr)
+		Manager->UnregisterProp(Actor);
+}
+
+void UPropPhysicsManager::UnregisterProp(AActor* Actor)
+{
+	FPropDefaults Defaults;
+	if (!Props.RemoveAndCopyValue(Actor, Defaults))
+		return;
+
+	if (UPrimitiveComponent* Root = Cast<UPrimitiveComponent>(Actor->GetRootComponent()))
+	{
+		Root->OnComponentWake.RemoveDynamic(this, &UPropPhysicsManager::OnPropWake);
+		Root->OnComponentSleep.RemoveDynamic(this, &UPropPhysicsManager::OnPropSleep);
+		Pending.Remove(Root);
+	}
+
+	// A dormant actor would keep its last replicated state forever, whatever happens to it next
+	if (Actor->NetDormancy == DORM_Awake)
+		NumAwake = FMath::Max(NumAwake - 1, 0);
+	else
+		Actor->SetNetDormancy(DORM_Awake);
+	Actor->FlushNetDormancy();
+
+	Actor->NetUpdateFrequency = Defaults.NetUpdateFrequency;
+	Actor->SetReplicateMovement(Defaults.bReplicateMovement);
+	FRepMovement& RepMovement = Actor->GetReplicatedMovement_Mutable();
+	RepMovement.LocationQuantizationLevel = Defaults.LocationQuantizationLevel;
+	RepMovement.VelocityQuantizationLevel = Defaults.VelocityQuantizationLevel;
+	RepMovement.RotationQuantizationLevel = Defaults.RotationQuantizationLevel;
+}
+
+void UPropPhysicsManager::OnPropWake(UPrimitiveComponent* WakingComponent, FName BoneName)
+{
+	AActor* Actor = WakingComponent->GetOwner();
+	if (Actor && Actor->NetDormancy != DORM_Awake)
+	{
+		Actor->SetNetDormancy(DORM_Awake);
+		++NumAwake;
+	}
+}
+
+void UPropPhysicsManager::OnPropSleep(UPrimitiveComponent* SleepingComponent, FName BoneName)
+{
+	AActor* Actor = SleepingComponent->GetOwner();
+	if (Actor && !SleepingComponent->IsSimulatingPhysics())
+	{
+		// Stopped simulating rather than settled, it is no longer a prop
+		UnregisterProp(Actor);
+	}
+	else if (Actor && Actor->NetDormancy == DORM_Awake)
+	{
+		Actor->ForceNetUpdate();
+		Actor->SetNetDormancy(DORM_DormantAll);
+		NumAwake = FMath::Max(NumAwake - 1, 0);
+	}
+}
+
+void UPropPhysicsManager::Report(FOutputDevice& Ar) const
+{
+	Ar.Logf(TEXT("Props: %d replicated, %d awake, %d impulses merged into %d body pushes"), Props.Num(), NumAwake,
+		NumImpulses, NumApplied);
+}
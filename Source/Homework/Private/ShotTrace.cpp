@@ -0,0 +1,243 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShotTrace.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static TAutoConsoleVariable<int32> CVarShotTrace(
+	TEXT("Homework.ShotTrace.Enable"),
+	0,
+	TEXT("Stamp every shot from input to the victim's HUD and write the stamps to Saved/Profiling/ShotTrace."));
+
+static FAutoConsoleCommandWithOutputDevice ShotTraceReportCommand(
+	TEXT("Homework.ShotTrace.Report"),
+	TEXT("Latency percentiles of the shots traced by this process."),
+	FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+	{
+		FShotTrace::Get().Flush();
+		FShotTrace::Get().Report(Ar);
+	}));
+
+namespace
+{
+	// Stamps of the same shot id further apart than this belong to a later shot
+	const double ShotWindow = 5.0;
+	const int32 NumClockSamples = 16;
+	const int32 FlushRecords = 256;
+	const int32 MaxRecords = 65536;
+
+	struct FShotInterval
+	{
+		const TCHAR* Name;
+		EShotStage From;
+		EShotStage To;
+	};
+
+	const FShotInterval Intervals[] = {
+		{ TEXT("Input -> server fire"), EShotStage::Input, EShotStage::ServerFire },
+		{ TEXT("Server fire -> trace"), EShotStage::ServerFire, EShotStage::ServerTrace },
+		{ TEXT("Trace -> damage"), EShotStage::ServerTrace, EShotStage::ServerDamage },
+		{ TEXT("Damage -> hit"), EShotStage::ServerDamage, EShotStage::ServerHit },
+		{ TEXT("Server hit -> victim HUD"), EShotStage::ServerHit, EShotStage::VictimHUD },
+		{ TEXT("Input -> ack"), EShotStage::Input, EShotStage::Ack },
+		{ TEXT("Input -> server hit"), EShotStage::Input, EShotStage::ServerHit },
+		{ TEXT("Input -> victim HUD"), EShotStage::Input, EShotStage::VictimHUD },
+	};
+
+	double Percentile(const TArray<double>& Sorted, double Fraction)
+	{
+		const int32 Index = FMath::Clamp(FMath::CeilToInt(Fraction * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+		return Sorted[Index];
+	}
+}
+
+FShotTrace& FShotTrace::Get()
+{
+	static FShotTrace Instance;
+	return Instance;
+}
+
+bool FShotTrace::IsEnabled()
+{
+	return CVarShotTrace.GetValueOnGameThread() != 0;
+}
+
+uint32 FShotTrace::MakeShotId(const APawn* Shooter, uint16 ShotSequence)
+{
+	const APlayerState* PlayerState = Shooter ? Shooter->GetPlayerState() : nullptr;
+	return PlayerState ? (uint32(PlayerState->GetPlayerId()) << 16) | ShotSequence : 0;
+}
+
+const TCHAR* FShotTrace::GetStageName(EShotStage Stage)
+{
+	switch (Stage)
+	{
+	case EShotStage::Input:			return TEXT("Input");
+	case EShotStage::ServerFire:	return TEXT("ServerFire");
+	case EShotStage::ServerTrace:	return TEXT("ServerTrace");
+	case EShotStage::ServerDamage:	return TEXT("ServerDamage");
+	case EShotStage::ServerHit:		return TEXT("ServerHit");
+	case EShotStage::Ack:			return TEXT("Ack");
+	case EShotStage::VictimHUD:		return TEXT("VictimHUD");
+	default:						return TEXT("Unknown");
+	}
+}
+
+void FShotTrace::Record(const UObject* WorldContext, uint32 ShotId, EShotStage Stage)
+{
+	Record(WorldContext, ShotId, Stage, FPlatformTime::Seconds());
+}
+
+void FShotTrace::Record(const UObject* WorldContext, uint32 ShotId, EShotStage Stage, double LocalTime)
+{
+	if (ShotId == 0 || !IsEnabled())
+		return;
+	const UWorld* World = WorldContext ? WorldContext->GetWorld() : nullptr;
+	const bool bClient = World && World->GetNetMode() == NM_Client;
+	Records.Add({ ShotId, Stage, bClient ? LocalTime + ClockOffset : LocalTime });
+	if (Records.Num() - NumFlushed >= FlushRecords)
+		Flush();
+}
+
+void FShotTrace::AddClockSample(double ClientSendTime, double ServerTime, double ClientReceiveTime)
+{
+	const FClockSample Sample = { ClientReceiveTime - ClientSendTime, ServerTime - (ClientSendTime + ClientReceiveTime) * 0.5 };
+	if (ClockSamples.Num() < NumClockSamples)
+		ClockSamples.Add(Sample);
+	else
+		ClockSamples[NextClockSample] = Sample;
+	NextClockSample = (NextClockSample + 1) % NumClockSamples;
+
+	// The fastest round trip has the least room for an asymmetric path
+	const FClockSample* Best = &ClockSamples[0];
+	for (const FClockSample& Candidate : ClockSamples)
+	{
+		if (Candidate.RoundTrip < Best->RoundTrip)
+			Best = &Candidate;
+	}
+	ClockOffset = Best->Offset;
+}
+
+void FShotTrace::Flush()
+{
+	if (NumFlushed == Records.Num())
+		return;
+	if (FilePath.IsEmpty())
+	{
+		FilePath = FPaths::ProfilingDir() / TEXT("ShotTrace") / FString::Printf(TEXT("ShotTrace-%s-%u.csv"),
+			*FDateTime::Now().ToString(), FPlatformProcess::GetCurrentProcessId());
+	}
+
+	FString Csv = NumFlushed == 0 ? FString(TEXT("ShotId,Stage,Time\n")) : FString();
+	for (int32 i = NumFlushed; i < Records.Num(); ++i)
+	{
+		Csv += FString::Printf(TEXT("%u,%s,%.6f\n"), Records[i].ShotId, GetStageName(Records[i].Stage), Records[i].Time);
+	}
+	FFileHelper::SaveStringToFile(Csv, *FilePath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(),
+		FILEWRITE_Append);
+	NumFlushed = Records.Num();
+
+	// Only the report needs them once written, keep the recent half
+	if (Records.Num() > MaxRecords)
+	{
+		Records.RemoveAt(0, MaxRecords / 2);
+		NumFlushed = Records.Num();
+	}
+}
+
+bool FShotTrace::ReadFile(const FString& Path, TArray<FShotTraceRecord>& OutRecords)
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *Path) || Lines.Num() == 0 || !Lines[0].StartsWith(TEXT("ShotId,")))
+		return false;
+	for (int32 i = 1; i < Lines.Num(); ++i)
+	{
+		TArray<FString> Fields;
+		if (Lines[i].ParseIntoArray(Fields, TEXT(",")) != 3)
+			continue;
+		for (uint8 Stage = 0; Stage < uint8(EShotStage::Num); ++Stage)
+		{
+			if (Fields[1] == GetStageName(EShotStage(Stage)))
+			{
+				OutRecords.Add({ uint32(FCString::Strtoui64(*Fields[0], nullptr, 10)), EShotStage(Stage),
+					FCString::Atod(*Fields[2]) });
+				break;
+			}
+		}
+	}
+	return true;
+}
+
+void FShotTrace::Report(FOutputDevice& Ar) const
+{
+	Report(Records, Ar);
+}
+
+void FShotTrace::Report(TArray<FShotTraceRecord> InRecords, FOutputDevice& Ar)
+{
+	// Every machine's stamps of a shot end up next to each other
+	InRecords.Sort([](const FShotTraceRecord& A, const FShotTraceRecord& B)
+	{
+		return A.ShotId != B.ShotId ? A.ShotId < B.ShotId : A.Time < B.Time;
+	});
+
+	TArray<TArray<double>> Samples;
+	Samples.SetNum(UE_ARRAY_COUNT(Intervals));
+	int32 NumShots = 0;
+	for (int32 Start = 0; Start < InRecords.Num();)
+	{
+		// First stamp of each stage wins, a shotgun damages several targets
+		double Times[uint8(EShotStage::Num)];
+		for (double& Time : Times)
+			Time = -1.0;
+		int32 End = Start;
+		for (; End < InRecords.Num() && InRecords[End].ShotId == InRecords[Start].ShotId
+			&& InRecords[End].Time - InRecords[Start].Time < ShotWindow; ++End)
+		{
+			double& Time = Times[uint8(InRecords[End].Stage)];
+			if (Time < 0.0)
+				Time = InRecords[End].Time;
+		}
+		Start = End;
+		++NumShots;
+
+		for (int32 i = 0; i < UE_ARRAY_COUNT(Intervals); ++i)
+		{
+			const double From = Times[uint8(Intervals[i].From)];
+			const double To = Times[uint8(Intervals[i].To)];
+			if (From >= 0.0 && To >= 0.0)
+				Samples[i].Add((To - From) * 1000.0);
+		}
+	}
+
+	Ar.Logf(TEXT("%d shots, %d stamps"), NumShots, InRecords.Num());
+	for (int32 i = 0; i < UE_ARRAY_COUNT(Intervals); ++i)
+	{
+		TArray<double>& Values = Samples[i];
+		if (Values.Num() == 0)
+		{
+			Ar.Logf(TEXT("%-26s no samples"), Intervals[i].Name);
+			continue;
+		}
+		Values.Sort();
+		Ar.Logf(TEXT("%-26s n %5d  p50 %7.2f ms  p90 %7.2f ms  p99 %7.2f ms  max %7.2f ms"), Intervals[i].Name,
+			Values.Num(), Percentile(Values, 0.5), Percentile(Values, 0.9), Percentile(Values, 0.99), Values.Last());
+	}
+}
+
+FShotTraceScope::FShotTraceScope(uint32 ShotId)
+	: PreviousShot(FShotTrace::Get().CurrentShot)
+{
+	FShotTrace::Get().CurrentShot = ShotId;
+}
+
+FShotTraceScope::~FShotTraceScope()
+{
+	FShotTrace::Get().CurrentShot = PreviousShot;
+}
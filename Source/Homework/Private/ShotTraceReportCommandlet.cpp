@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShotTraceReportCommandlet.h"
+#include "ShotTrace.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+int32 UShotTraceReportCommandlet::Main(const FString& Params)
+{
+	FString Dir;
+	if (!FParse::Value(*Params, TEXT("dir="), Dir))
+	{
+		Dir = FPaths::ProfilingDir() / TEXT("ShotTrace");
+	}
+
+	TArray<FString> Files;
+	IFileManager::Get().FindFiles(Files, *(Dir / TEXT("*.csv")), true, false);
+	TArray<FShotTraceRecord> Records;
+	for (const FString& File : Files)
+	{
+		if (!FShotTrace::ReadFile(Dir / File, Records))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s is not a shot trace, skipped"), *File);
+		}
+	}
+	if (Records.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("No shot trace stamps in %s"), *Dir);
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("%d shot trace files from %s"), Files.Num(), *Dir);
+	FShotTrace::Report(MoveTemp(Records), *GLog);
+	return 0;
+}
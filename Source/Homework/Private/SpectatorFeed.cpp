@@ -0,0 +1,204 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SpectatorFeed.h"
+#include "../HomeworkCharacter.h"
+#include "AICharacter.h"
+#include "DeathMatchGameState.h"
+#include "MultiFPSPlayerController.h"
+#include "WeaponBaseServer.h"
+#include "Engine/NetConnection.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Net/UnrealNetwork.h"
+#include "TimerManager.h"
+
+#if !UE_BUILD_SHIPPING
+// Homework.Spectator.Bandwidth: average outgoing bytes per second of spectator and player connections
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice SpectatorBandwidthCommand(
+	TEXT("Homework.Spectator.Bandwidth"),
+	TEXT("Compares the outgoing bandwidth of low bandwidth spectator connections with player connections."),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		if (!World)
+			return;
+		int64 SpectatorBytes = 0;
+		int64 PlayerBytes = 0;
+		int32 NumSpectators = 0;
+		int32 NumPlayers = 0;
+		for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+		{
+			const AMultiFPSPlayerController* PlayerController = Cast<AMultiFPSPlayerController>(It->Get());
+			const UNetConnection* Connection = PlayerController ? PlayerController->GetNetConnection() : nullptr;
+			if (!Connection)
+				continue;
+			if (PlayerController->IsLowBandwidthSpectating())
+			{
+				SpectatorBytes += Connection->OutBytesPerSecond;
+				++NumSpectators;
+			}
+			else
+			{
+				PlayerBytes += Connection->OutBytesPerSecond;
+				++NumPlayers;
+			}
+		}
+		const double SpectatorAverage = NumSpectators > 0 ? double(SpectatorBytes) / NumSpectators : 0.0;
+		const double PlayerAverage = NumPlayers > 0 ? double(PlayerBytes) / NumPlayers : 0.0;
+		Ar.Logf(TEXT("%d spectators at %.0f bytes/s, %d players at %.0f bytes/s, spectators use %.1f%%"),
+			NumSpectators, SpectatorAverage, NumPlayers, PlayerAverage,
+			PlayerAverage > 0.0 ? SpectatorAverage / PlayerAverage * 100.0 : 0.0);
+	}));
+#endif
+
+namespace
+{
+	bool GetCombatantState(AActor* Actor, float& OutHP, AWeaponBaseServer*& OutWeapon)
+	{
+		if (AHomeworkCharacter* Player = Cast<AHomeworkCharacter>(Actor))
+		{
+			OutHP = Player->HP;
+			OutWeapon = Player->GetCurrentServerWeapon();
+			return true;
+		}
+		if (AAICharacter* AI = Cast<AAICharacter>(Actor))
+		{
+			OutHP = AI->HP;
+			OutWeapon = AI->GetCurrentServerWeapon();
+			return true;
+		}
+		return false;
+	}
+}
+
+ASpectatorFeed::ASpectatorFeed()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	bReplicates = true;
+	bAlwaysRelevant = false;
+	UpdateRate = 4.0f;
+	NetUpdateFrequency = UpdateRate;
+}
+
+ASpectatorFeed* ASpectatorFeed::FindOrSpawn(UWorld* World)
+{
+	for (TActorIterator<ASpectatorFeed> It(World); It; ++It)
+	{
+		return *It;
+	}
+	return World->SpawnActor<ASpectatorFeed>();
+}
+
+void ASpectatorFeed::BeginPlay()
+{
+	Super::BeginPlay();
+	NetUpdateFrequency = UpdateRate;
+	if (HasAuthority())
+	{
+		GetWorldTimerManager().SetTimer(UpdateTimer, this, &ASpectatorFeed::UpdateEntries, 1.0f / UpdateRate, true);
+	}
+}
+
+bool ASpectatorFeed::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	return AMultiFPSPlayerController::IsLowBandwidthSpectator(RealViewer);
+}
+
+AActor* ASpectatorFeed::FindCombatant(uint16 PlayerId) const
+{
+	const FCombatant* Combatant = Combatants.Find(PlayerId);
+	return Combatant ? Combatant->Actor.Get() : nullptr;
+}
+
+bool ASpectatorFeed::GetEntry(int32 Index, int32& PlayerId, FVector& Location, FRotator& ViewRotation, bool& bAlive) const
+{
+	if (!Entries.Items.IsValidIndex(Index))
+		return false;
+	const FSpectatorFeedItem& Item = Entries.Items[Index];
+	PlayerId = Item.PlayerId;
+	Location = Item.Location;
+	ViewRotation = FRotator(FRotator::DecompressAxisFromByte(Item.Pitch), FRotator::DecompressAxisFromByte(Item.Yaw), 0.0f);
+	bAlive = Item.bAlive;
+	return true;
+}
+
+void ASpectatorFeed::UpdateEntries()
+{
+	bool bAnySpectator = false;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It && !bAnySpectator; ++It)
+	{
+		bAnySpectator = AMultiFPSPlayerController::IsLowBandwidthSpectator(It->Get());
+	}
+	ADeathMatchGameState* GameState = GetWorld()->GetGameState<ADeathMatchGameState>();
+	if (!bAnySpectator || !GameState)
+		return;
+
+	TSet<uint16> Seen;
+	for (TActorIterator<ACharacter> It(GetWorld()); It; ++It)
+	{
+		float HP;
+		AWeaponBaseServer* Weapon;
+		// Only combatants that already have a scoreboard row, the feed never adds one
+		uint16 Id;
+		if (!GetCombatantState(*It, HP, Weapon) || !GameState->FindPlayerId(*It, Id))
+			continue;
+		Seen.Add(Id);
+
+		FCombatant& Combatant = Combatants.FindOrAdd(Id);
+		const uint8 ShotCounter = Weapon ? Weapon->ShotCounter : 0;
+		// A respawned pawn or a new weapon starts a new baseline
+		if (Combatant.Actor != *It || Combatant.Weapon != Weapon)
+		{
+			Combatant.Actor = *It;
+			Combatant.Weapon = Weapon;
+			Combatant.LastShotCounter = ShotCounter;
+			Combatant.LastHP = HP;
+		}
+
+		FSpectatorFeedItem* Item = Entries.Items.FindByPredicate([Id](const FSpectatorFeedItem& Entry) { return Entry.PlayerId == Id; });
+		bool bChanged = Item == nullptr;
+		if (!Item)
+		{
+			Item = &Entries.Items.AddDefaulted_GetRef();
+			Item->PlayerId = Id;
+		}
+		auto Update = [&bChanged](auto& Field, const auto& Value)
+		{
+			if (!(Field == Value))
+			{
+				Field = Value;
+				bChanged = true;
+			}
+		};
+		const FRotator View = It->GetBaseAimRotation();
+		Update(Item->Location, FVector_NetQuantize(It->GetActorLocation().GridSnap(25.0f)));
+		Update(Item->Yaw, FRotator::CompressAxisToByte(View.Yaw));
+		Update(Item->Pitch, FRotator::CompressAxisToByte(View.Pitch));
+		Update(Item->bAlive, HP > 0.0f);
+		Update(Item->Shots, uint8(ShotCounter - Combatant.LastShotCounter));
+		Update(Item->DamageTaken, uint8(FMath::Clamp(FMath::RoundToInt(Combatant.LastHP - HP), 0, 255)));
+		Combatant.LastShotCounter = ShotCounter;
+		Combatant.LastHP = HP;
+		if (bChanged)
+		{
+			Entries.MarkItemDirty(*Item);
+		}
+	}
+
+	for (int32 Index = Entries.Items.Num() - 1; Index >= 0; --Index)
+	{
+		if (!Seen.Contains(Entries.Items[Index].PlayerId))
+		{
+			Combatants.Remove(Entries.Items[Index].PlayerId);
+			Entries.Items.RemoveAtSwap(Index);
+			Entries.MarkArrayDirty();
+		}
+	}
+}
+
+void ASpectatorFeed::GetLifetimeReplicatedProps(
+	TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME(ASpectatorFeed, Entries);
+}
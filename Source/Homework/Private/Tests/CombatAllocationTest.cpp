@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AllocationCounter.h"
+#include "HitResolver.h"
+#include "../../HomeworkCharacter.h"
+#include "../../HomeworkGameMode.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCombatAllocationTest, "Homework.Combat.Allocations",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FCombatAllocationTest::RunTest(const FString& Parameters)
+{
+	if (!FScopedAllocationCounter::IsInstalled())
+	{
+		AddWarning(TEXT("Needs a monolithic build started with -homeworkalloccount, nothing was counted"));
+		return true;
+	}
+	UClass* PawnClass = GetDefault<AHomeworkGameMode>()->DefaultPawnClass;
+	if (!PawnClass || !PawnClass->IsChildOf<AHomeworkCharacter>())
+	{
+		AddError(TEXT("The game mode's default pawn is not a Homework character"));
+		return false;
+	}
+
+	// A bare game world, nothing else ticks or allocates while the batch is counted
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	AHomeworkCharacter* Shooter = World->SpawnActor<AHomeworkCharacter>(PawnClass, FTransform(FVector(-1000.0f, 0.0f, 0.0f)));
+	AHomeworkCharacter* Target = World->SpawnActor<AHomeworkCharacter>(PawnClass, FTransform::Identity);
+	UHitResolver* Resolver = World->GetSubsystem<UHitResolver>();
+
+	bool bPassed = false;
+	if (!Shooter || !Target || !Resolver)
+	{
+		AddError(TEXT("Could not spawn the shooter and the target"));
+	}
+	else
+	{
+		// The characters never begin play, the damage handler is bound here instead
+		Target->OnTakePointDamage.AddDynamic(Target, &AHomeworkCharacter::OnHit);
+		IConsoleVariable* ParallelVar = IConsoleManager::Get().FindConsoleVariable(TEXT("Homework.Hits.Parallel"));
+		const int32 SavedParallel = ParallelVar->GetInt();
+		ParallelVar->Set(1, ECVF_SetByCode);
+
+		// Shotgun blasts, the middle pellets hit the target and the outer ones fly off into nothing
+		const FVector Start = Shooter->GetActorLocation();
+		const FVector Forward = (Target->GetActorLocation() - Start).GetSafeNormal();
+		const int32 NumPellets = 8;
+		FVector Pellets[NumPellets];
+		for (int32 i = 0; i < NumPellets; ++i)
+		{
+			Pellets[i] = Start + Forward * 5000.0f + FVector(0.0f, (i - NumPellets / 2) * 40.0f, 0.0f);
+		}
+
+		// Several shots queued before one flush, as the fire RPCs of a tick do, so the batch goes to the workers.
+		// From more shots than there are workers the resolve tasks come back out of the task pool
+		auto FireBatch = [&](int32 NumShots)
+		{
+			for (int32 Shot = 0; Shot < NumShots; ++Shot)
+			{
+				Resolver->Queue(Shooter, Start, MakeArrayView(Pellets), Forward, 1.0f, 0);
+			}
+			Resolver->Flush();
+		};
+
+		const float TestHP = 1.0e6f;
+		Target->HP = TestHP;
+		bPassed = true;
+		for (int32 NumShots : { 2, 8, 32 })
+		{
+			// Warmed up first so the resolver's and the hitbox cache's buffers have grown
+			for (int32 i = 0; i < 4; ++i)
+			{
+				FireBatch(NumShots);
+			}
+			const float WarmHP = Target->HP;
+
+			int32 Allocations;
+			int64 Bytes;
+			{
+				FScopedAllocationCounter Counter;
+				FireBatch(NumShots);
+				Allocations = Counter.GetAllocations();
+				Bytes = Counter.GetBytes();
+			}
+			bPassed &= TestTrue(FString::Printf(TEXT("%d shots damaged the target"), NumShots), Target->HP < WarmHP)
+				&& TestEqual(FString::Printf(TEXT("%d shots of %d pellets, allocations on any thread (%lld bytes)"),
+					NumShots, NumPellets, Bytes), Allocations, 0);
+		}
+		ParallelVar->Set(SavedParallel, ECVF_SetByCode);
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	return bPassed;
+}
+#endif
@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DeathMatchScoreboard.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDeathMatchScoreboardRankOrderTest, "Homework.Scoreboard.RankOrder",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Every row's rank has to match its position, and the scores have to be in SortValues order
+static bool CheckBoard(FAutomationTestBase& Test, const FDeathMatchScoreboard& Board, const TMap<FName, int32>& Scores,
+	const TCHAR* Step)
+{
+	TArray<FDeathMatchPlayerData> Values;
+	for (const TPair<FName, int32>& Score : Scores)
+	{
+		FDeathMatchPlayerData Data;
+		Data.PlayerName = Score.Key;
+		Data.PlayerScore = Score.Value;
+		Values.Add(Data);
+	}
+	UKisMetMultiFPSLibrary::SortValues(Values);
+
+	if (!Test.TestEqual(FString::Printf(TEXT("%s: players"), Step), Board.Num(), Values.Num()))
+		return false;
+	const TArray<FDeathMatchPlayerData>& Ranked = Board.GetRanked();
+	for (int32 Rank = 0; Rank < Ranked.Num(); ++Rank)
+	{
+		const FName Name = Ranked[Rank].PlayerName;
+		if (!Test.TestEqual(FString::Printf(TEXT("%s: score at rank %d"), Step, Rank), Ranked[Rank].PlayerScore, Values[Rank].PlayerScore)
+			|| !Test.TestEqual(FString::Printf(TEXT("%s: score of %s"), Step, *Name.ToString()), Ranked[Rank].PlayerScore, Scores.FindRef(Name))
+			|| !Test.TestEqual(FString::Printf(TEXT("%s: rank of %s"), Step, *Name.ToString()), Board.GetRank(Name), Rank))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FDeathMatchScoreboardRankOrderTest::RunTest(const FString& Parameters)
+{
+	const int32 NumPlayers = 64;
+	FRandomStream Random(NumPlayers);
+	FDeathMatchScoreboard Board;
+	TMap<FName, int32> Scores;
+	for (int32 i = 0; i < NumPlayers; ++i)
+	{
+		const FName Name(TEXT("Player"), i);
+		Board.AddPlayer(Name);
+		Scores.Add(Name, 0);
+	}
+
+	// Kills, deaths that lower a score and players leaving and joining, checked after every change
+	for (int32 Step = 0; Step < 2000; ++Step)
+	{
+		const FName Name(TEXT("Player"), Random.RandHelper(NumPlayers));
+		const int32 Action = Random.RandHelper(10);
+		if (Action == 0)
+		{
+			TestEqual(TEXT("Remove reports whether the player was on the board"), Board.RemovePlayer(Name), Scores.Remove(Name) > 0);
+		}
+		else if (Action == 1)
+		{
+			const int32 Score = Random.RandRange(-5, 50);
+			Board.SetScore(Name, Score);
+			Scores.Add(Name, Score);
+		}
+		else
+		{
+			const int32 Delta = Action == 2 ? -1 : 1;
+			Board.AddScore(Name, Delta);
+			Scores.FindOrAdd(Name) += Delta;
+		}
+		if (!CheckBoard(*this, Board, Scores, *FString::Printf(TEXT("Step %d"), Step)))
+			return false;
+	}
+
+	// A board serialized over a copy with the same number of rows (replication, Blueprint) keeps the
+	// copy's stale index unless PostSerialize rebuilds it
+	if (!TestTrue(TEXT("Players left on the board"), Board.Num() > 0))
+		return false;
+	FDeathMatchScoreboard Copy = Board;
+	const FName Name = Board.GetRanked().Last().PlayerName;
+	Board.AddScore(Name, 100);
+	Scores.FindOrAdd(Name) += 100;
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	FObjectAndNameAsStringProxyArchive WriterProxy(Writer, false);
+	FDeathMatchScoreboard::StaticStruct()->SerializeItem(WriterProxy, &Board, nullptr);
+	FMemoryReader Reader(Bytes);
+	FObjectAndNameAsStringProxyArchive ReaderProxy(Reader, false);
+	FDeathMatchScoreboard::StaticStruct()->SerializeItem(ReaderProxy, &Copy, nullptr);
+	return CheckBoard(*this, Copy, Scores, TEXT("Serialized copy"));
+}
+#endif
@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Hitbox.h"
+#include "../../HomeworkGameMode.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHitboxKernelParityTest, "Homework.Hitbox.KernelParity",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FHitboxKernelParityTest::RunTest(const FString& Parameters)
+{
+	// Counts that are not a multiple of 4 exercise the padding of the last SIMD group
+	FRandomStream Random(35);
+	for (int32 NumCapsules : { 1, 3, 4, 7, 16, 33 })
+	{
+		FHitboxCapsules Capsules;
+		for (int32 i = 0; i < NumCapsules; ++i)
+		{
+			const FVector A = Random.GetUnitVector() * Random.FRandRange(0.0f, 100.0f);
+			Capsules.Add(A, A + Random.GetUnitVector() * Random.FRandRange(0.0f, 40.0f), Random.FRandRange(2.0f, 20.0f),
+				i % 3, NAME_None, nullptr);
+		}
+		for (int32 Ray = 0; Ray < 500; ++Ray)
+		{
+			const FVector Start = Random.GetUnitVector() * 400.0f;
+			const FVector End = Random.GetUnitVector() * Random.FRandRange(0.0f, 120.0f);
+			const int32 IgnoreOwner = Ray % 4 == 0 ? Ray % 3 : INDEX_NONE;
+			float SimdTime = 0.0f, ScalarTime = 0.0f;
+			const int32 Simd = Capsules.Intersect(Start, End, SimdTime, IgnoreOwner);
+			const int32 Scalar = Capsules.IntersectScalar(Start, End, ScalarTime, IgnoreOwner);
+			if (!TestEqual(FString::Printf(TEXT("%d capsules, ray %d: capsule"), NumCapsules, Ray), Simd, Scalar))
+				return false;
+			if (Simd != INDEX_NONE
+				&& !TestEqual(FString::Printf(TEXT("%d capsules, ray %d: time"), NumCapsules, Ray), SimdTime, ScalarTime, 1.0e-4f))
+				return false;
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHitboxZoneParityTest, "Homework.Hitbox.ZoneParity",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FHitboxZoneParityTest::RunTest(const FString& Parameters)
+{
+	const AGameModeBase* GameMode = GetDefault<AHomeworkGameMode>();
+	UClass* PawnClass = GameMode->DefaultPawnClass;
+	if (!PawnClass || !PawnClass->IsChildOf<ACharacter>())
+	{
+		AddError(TEXT("The game mode's default pawn is not a character"));
+		return false;
+	}
+
+	// A bare game world, the character is never possessed and never begins play
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	ACharacter* Character = World->SpawnActor<ACharacter>(PawnClass, FTransform::Identity);
+	USkeletalMeshComponent* Mesh = Character ? Character->GetMesh() : nullptr;
+
+	bool bPassed = false;
+	if (!Mesh || !Mesh->GetPhysicsAsset())
+	{
+		AddError(FString::Printf(TEXT("%s has no mesh with a physics asset"), *PawnClass->GetName()));
+	}
+	else
+	{
+		// The physics asset traced on its own is the reference the capsules have to agree with
+		FCollisionQueryParams Params(SCENE_QUERY_STAT(HitboxZoneParity), true);
+		Params.bReturnPhysicalMaterial = true;
+		FRandomStream Random(1000);
+		const FBoxSphereBounds& Bounds = Mesh->Bounds;
+		int32 NumHits = 0, NumMatches = 0;
+		for (int32 Ray = 0; Ray < 1000; ++Ray)
+		{
+			const FVector Aim = Bounds.Origin + Random.GetUnitVector() * Bounds.SphereRadius * 0.5f;
+			const FVector Start = Aim + Random.GetUnitVector() * 2000.0f;
+			const FVector End = Start + (Aim - Start).GetSafeNormal() * 5000.0f;
+
+			FHitResult TraceHit, HitboxHit;
+			const bool bTraceHit = Mesh->LineTraceComponent(TraceHit, Start, End, Params);
+			FHitboxQuery::LineTrace(World, MakeArrayView(&Character, 1), Start, End, nullptr, HitboxHit);
+			const bool bHitboxHit = HitboxHit.GetActor() == Character;
+			if (!bTraceHit && !bHitboxHit)
+				continue;
+			++NumHits;
+			if (bTraceHit && bHitboxHit
+				&& FHitboxQuery::GetZone(TraceHit.PhysMaterial.Get()) == FHitboxQuery::GetZone(HitboxHit.PhysMaterial.Get()))
+			{
+				++NumMatches;
+			}
+		}
+
+		// Boxes and convex hulls become capsules, rays grazing their corners may land on either side
+		const float MinParity = 0.95f;
+		bPassed = TestTrue(TEXT("Rays hit the character"), NumHits > 0)
+			&& TestTrue(FString::Printf(TEXT("Zone parity %d/%d is at least %.0f%%"), NumMatches, NumHits, MinParity * 100.0f),
+				NumMatches >= NumHits * MinParity);
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	return bPassed;
+}
+#endif
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "../../HomeworkCharacter.h"
+#include "../../HomeworkGameMode.h"
+#include "Blueprint/UserWidget.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FScopeWidgetLifecycleTest, "Homework.UI.ScopeLifecycle",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FScopeWidgetLifecycleTest::RunTest(const FString& Parameters)
+{
+	UClass* PawnClass = GetDefault<AHomeworkGameMode>()->DefaultPawnClass;
+	if (!PawnClass || !PawnClass->IsChildOf<AHomeworkCharacter>())
+	{
+		AddError(TEXT("The game mode's default pawn is not a Homework character"));
+		return false;
+	}
+
+	// A standalone game instance so widgets can be created, there is no viewport to show them in
+	UGameInstance* GameInstance = NewObject<UGameInstance>(GEngine);
+	GameInstance->InitializeStandalone();
+	UWorld* World = GameInstance->GetWorld();
+	AHomeworkCharacter* Character = World->SpawnActor<AHomeworkCharacter>(PawnClass, FTransform::Identity);
+
+	bool bPassed = false;
+	if (!Character || !Character->GetScopeClass())
+	{
+		AddError(FString::Printf(TEXT("%s has no sniper scope widget class"), *PawnClass->GetName()));
+	}
+	else
+	{
+		// Toggling reuses one widget and only changes its visibility
+		Character->SetScopeVisible(true);
+		UUserWidget* Scope = Character->GetScopeWidget();
+		bPassed = TestNotNull(TEXT("Scope created on first use"), Scope);
+		for (int32 i = 0; bPassed && i < 10; ++i)
+		{
+			Character->SetScopeVisible(false);
+			bPassed &= TestEqual(TEXT("Scope out collapses it"), Scope->GetVisibility(), ESlateVisibility::Collapsed);
+			Character->SetScopeVisible(true);
+			bPassed &= TestTrue(TEXT("Scope in reuses it"), Character->GetScopeWidget() == Scope)
+				&& TestEqual(TEXT("Scope in shows it"), Scope->GetVisibility(), ESlateVisibility::HitTestInvisible);
+		}
+
+		// Death and unpossess drop it, the next scope in builds a fresh one
+		Character->RemoveScope();
+		bPassed &= TestNull(TEXT("Scope dropped"), Character->GetScopeWidget());
+		Character->SetScopeVisible(true);
+		bPassed &= TestNotNull(TEXT("Scope created again"), Character->GetScopeWidget());
+		Character->RemoveScope();
+	}
+
+	GameInstance->Shutdown();
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	return bPassed;
+}
+#endif
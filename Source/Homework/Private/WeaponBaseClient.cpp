@@ -2,6 +2,7 @@
 
 
 #include "WeaponBaseClient.h"
+#include "MemoryTags.h"
 
 
 // Sets default values
@@ -31,6 +32,7 @@ void AWeaponBaseClient::Tick(float DeltaTime)
 
 void AWeaponBaseClient::DisplayWeaponEffect()
 {
+	LLM_SCOPE_BYTAG(Homework_Effects);
 	UGameplayStatics::PlaySound2D(GetWorld(), FireSound);
 	UGameplayStatics::SpawnEmitterAttached(MuzzleFlash, WeaponMesh, TEXT("Fire_Slot"),
 		FVector::ZeroVector, FRotator::ZeroRotator, FVector::OneVector, EAttachLocation::KeepRelativeOffset,
@@ -5,6 +5,10 @@
 #include "AICharacter.h"
 #include "Kismet/GameplayStatics.h"
 #include "Net/UnrealNetwork.h"
+#include "NetStatsCollector.h"
+#include "WeaponMaterialTable.h"
+#include "MemoryTags.h"
+#include "PropPhysicsManager.h"
 
 // Sets default values
 AWeaponBaseServer::AWeaponBaseServer()
@@ -25,6 +29,13 @@ AWeaponBaseServer::AWeaponBaseServer()
 	WeaponMesh->SetEnableGravity(true);
 	WeaponMesh->SetSimulatePhysics(true);
 
+	PelletCount = 8;
+	PelletSpreadAngle = 5.0f;
+	ShotgunClipBullets = 8;
+	ShotgunPelletDamageScale = 0.35f;
+	ShotCounter = 0;
+	ReloadCounter = 0;
+
 	bReplicates = true;
 }
 
@@ -56,13 +67,17 @@ void AWeaponBaseServer::EquipWeapon(bool IsPlayer)
 {
 	if (!IsPlayer)
 	{
-		FString PathToLoad = "Material'/Game/Asset/Weapon/FPWeapon/Materials/M_FPGun_2.M_FPGun_2'";
-
-		WeaponMesh->SetMaterial(0, Cast<UMaterialInterface>(StaticLoadObject(
-			UMaterial::StaticClass(), nullptr, *(PathToLoad))));
+		UWeaponMaterialTable* MaterialTable = GetWorld()->GetSubsystem<UWeaponMaterialTable>();
+		// Without the variant the weapon keeps its own material
+		if (UMaterialInterface* Material = MaterialTable ? MaterialTable->GetMaterial(UWeaponMaterialTable::AIVariant) : nullptr)
+		{
+			WeaponMesh->SetMaterial(0, Material);
+		}
 	}
 	WeaponMesh->SetEnableGravity(false);
 	WeaponMesh->SetSimulatePhysics(false);
+	// Held from now on, nothing may keep it dormant or at prop rates
+	UPropPhysicsManager::Unregister(this);
 
 	SphereCollison->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 	WeaponMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
@@ -73,33 +88,90 @@ void AWeaponBaseServer::SetVisible(bool IsVisible)
 	WeaponMesh->SetVisibility(IsVisible);
 }
 
-void AWeaponBaseServer::MultiShootingEffect_Implementation()
+void AWeaponBaseServer::ConfigureAsShotgun()
 {
-	if (GetOwner() != UGameplayStatics::GetPlayerPawn(GetWorld(), 0))
+	KindOfWeapon = EWeaponType::Shotgun;
+	IsAutoMatic = false;
+	BaseDamage *= ShotgunPelletDamageScale;
+	// Same number of spare clips as the weapon it is built from
+	const int32 SpareClips = GunCurrentBullet / FMath::Max(ClipMaxBullet, 1);
+	ClipMaxBullet = ShotgunClipBullets;
+	// Replicated, clients keep what the server sent
+	if (HasAuthority())
 	{
-		UGameplayStatics::PlaySoundAtLocation(GetWorld(), FireSound, GetActorLocation());
-		UGameplayStatics::SpawnEmitterAttached(MuzzleFlash, WeaponMesh, TEXT("Fire_Slot"),
-			FVector::ZeroVector, FRotator::ZeroRotator, FVector::OneVector, 
-			EAttachLocation::KeepRelativeOffset, true, EPSCPoolMethod::None, true);
+		ClipCurrentBullet = ShotgunClipBullets;
+		GunCurrentBullet = SpareClips * ShotgunClipBullets;
 	}
 }
 
-bool AWeaponBaseServer::MultiShootingEffect_Validate()
+void AWeaponBaseServer::OnRep_KindOfWeapon()
+{
+	if (KindOfWeapon == EWeaponType::Shotgun && GetDefault<AWeaponBaseServer>(GetClass())->KindOfWeapon != EWeaponType::Shotgun)
+	{
+		ConfigureAsShotgun();
+	}
+}
+
+void AWeaponBaseServer::NotifyShot()
+{
+	++ShotCounter;
+	PlayShootingEffect();
+}
+
+void AWeaponBaseServer::NotifyReload()
+{
+	++ReloadCounter;
+	PlayReloadEffect();
+}
+
+void AWeaponBaseServer::OnRep_ShotCounter()
 {
-	return true;
+	// Initial replication of a weapon becoming relevant is not a shot
+	if (HasActorBegunPlay())
+		PlayShootingEffect();
 }
 
-void AWeaponBaseServer::MultiReloadEffect_Implementation()
+void AWeaponBaseServer::OnRep_ReloadCounter()
 {
-	if (GetOwner() != UGameplayStatics::GetPlayerPawn(GetWorld(), 0))
+	if (HasActorBegunPlay())
+		PlayReloadEffect();
+}
+
+bool AWeaponBaseServer::IsHeldByLocalPlayer() const
+{
+	const APawn* Holder = Cast<APawn>(GetOwner());
+	return Holder && Holder->IsLocallyControlled();
+}
+
+void AWeaponBaseServer::PlayShootingEffect()
+{
+	// The body montage also poses the server hitboxes
+	ACharacter* Holder = Cast<ACharacter>(GetOwner());
+	UAnimInstance* BodyAnim = Holder ? Holder->GetMesh()->GetAnimInstance() : nullptr;
+	if (BodyAnim)
 	{
-		UGameplayStatics::PlaySoundAtLocation(GetWorld(), ReloadSound, GetActorLocation());
+		BodyAnim->Montage_Play(ServerTPBodysShootAnimMontage);
 	}
+	if (GetNetMode() == NM_DedicatedServer || IsHeldByLocalPlayer())
+		return;
+	LLM_SCOPE_BYTAG(Homework_Effects);
+	UGameplayStatics::PlaySoundAtLocation(GetWorld(), FireSound, GetActorLocation());
+	UGameplayStatics::SpawnEmitterAttached(MuzzleFlash, WeaponMesh, TEXT("Fire_Slot"),
+		FVector::ZeroVector, FRotator::ZeroRotator, FVector::OneVector, 
+		EAttachLocation::KeepRelativeOffset, true, EPSCPoolMethod::None, true);
 }
 
-bool AWeaponBaseServer::MultiReloadEffect_Validate()
+void AWeaponBaseServer::PlayReloadEffect()
 {
-	return true;
+	ACharacter* Holder = Cast<ACharacter>(GetOwner());
+	UAnimInstance* BodyAnim = Holder ? Holder->GetMesh()->GetAnimInstance() : nullptr;
+	if (BodyAnim)
+	{
+		BodyAnim->Montage_Play(ServerTPBodysReloadAnimMontage);
+	}
+	if (GetNetMode() == NM_DedicatedServer || IsHeldByLocalPlayer())
+		return;
+	UGameplayStatics::PlaySoundAtLocation(GetWorld(), ReloadSound, GetActorLocation());
 }
 
 void AWeaponBaseServer::GetLifetimeReplicatedProps(
@@ -107,6 +179,25 @@ void AWeaponBaseServer::GetLifetimeReplicatedProps(
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 	DOREPLIFETIME_CONDITION(AWeaponBaseServer, ClipCurrentBullet, COND_None);
 	DOREPLIFETIME_CONDITION(AWeaponBaseServer, GunCurrentBullet, COND_None);
+	DOREPLIFETIME_CONDITION(AWeaponBaseServer, KindOfWeapon, COND_InitialOnly);
+	// The owning client already predicted its shots and reloads
+	DOREPLIFETIME_CONDITION(AWeaponBaseServer, ShotCounter, COND_SkipOwner);
+	DOREPLIFETIME_CONDITION(AWeaponBaseServer, ReloadCounter, COND_SkipOwner);
+}
+
+bool AWeaponBaseServer::CallRemoteFunction(UFunction* Function, void* Parameters,
+	FOutParmRec* OutParms, FFrame* Stack)
+{
+	FNetStatsRPCScope NetStatsScope(this, Function);
+	return Super::CallRemoteFunction(Function, Parameters, OutParms, Stack);
+}
+
+bool AWeaponBaseServer::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	// Spectators get ammo only for the weapon of the player they watch
+	if (AMultiFPSPlayerController::IsFilteredForSpectator(RealViewer, GetOwner() ? GetOwner() : this))
+		return false;
+	return Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
 }
 
 void AWeaponBaseServer::BeginPlay()
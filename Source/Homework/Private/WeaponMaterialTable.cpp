@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WeaponMaterialTable.h"
+#include "Homework.h"
+#include "HitchCapture.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Weapon Material Equips"), STAT_WeaponMaterialEquips, STATGROUP_Homework);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Weapon Material Loads"), STAT_WeaponMaterialLoads, STATGROUP_Homework);
+
+// Run after a spawn wave, loads should stay at zero
+static FAutoConsoleCommandWithWorldAndArgs CmdWeaponMaterials(
+	TEXT("Homework.WeaponMaterials.Stats"),
+	TEXT("Logs and resets the weapon material equips and loads of this world."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UWeaponMaterialTable* Table = World ? World->GetSubsystem<UWeaponMaterialTable>() : nullptr)
+		{
+			UE_LOG(LogTemp, Log, TEXT("Weapon materials: %d equips, %d loads"), Table->NumEquips, Table->NumLoads);
+			Table->NumEquips = 0;
+			Table->NumLoads = 0;
+		}
+	}));
+
+const FName UWeaponMaterialTable::AIVariant(TEXT("AI"));
+
+UWeaponMaterialTable::UWeaponMaterialTable()
+{
+	Variants.Add(AIVariant, TSoftObjectPtr<UMaterialInterface>(
+		FSoftObjectPath(TEXT("/Game/Asset/Weapon/FPWeapon/Materials/M_FPGun_2.M_FPGun_2"))));
+}
+
+bool UWeaponMaterialTable::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void UWeaponMaterialTable::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	for (const TPair<FName, TSoftObjectPtr<UMaterialInterface>>& Variant : Variants)
+	{
+		LoadVariant(Variant.Key);
+	}
+}
+
+UMaterialInstanceDynamic* UWeaponMaterialTable::GetMaterial(FName Variant)
+{
+	++NumEquips;
+	INC_DWORD_STAT(STAT_WeaponMaterialEquips);
+	if (UMaterialInstanceDynamic* const* Material = Materials.Find(Variant))
+		return *Material;
+	++NumLoads;
+	INC_DWORD_STAT(STAT_WeaponMaterialLoads);
+	return LoadVariant(Variant);
+}
+
+UMaterialInstanceDynamic* UWeaponMaterialTable::LoadVariant(FName Variant)
+{
+	HITCH_SCOPE("UWeaponMaterialTable::LoadVariant");
+	FHitchCapture::Get().AddEvent(TEXT("WeaponLoad"), this);
+	const TSoftObjectPtr<UMaterialInterface>* Path = Variants.Find(Variant);
+	if (!Path)
+		return nullptr;
+	UMaterialInterface* Parent = Path->LoadSynchronous();
+	if (!Parent)
+	{
+		// Remembered as missing, equips don't retry the synchronous load
+		UE_LOG(LogTemp, Warning, TEXT("Weapon material %s could not be loaded from %s"), *Variant.ToString(),
+			*Path->ToString());
+		Materials.Add(Variant, nullptr);
+		return nullptr;
+	}
+	UMaterialInstanceDynamic* Material = UMaterialInstanceDynamic::Create(Parent, this);
+	Materials.Add(Variant, Material);
+	return Material;
+}
@@ -15,7 +15,7 @@ class HOMEWORK_API AAICharacter : public ACharacter
 
 public:
 	// Sets default values for this character's properties
-	AAICharacter();
+	AAICharacter(const FObjectInitializer& ObjectInitializer);
 
 	UPROPERTY(VisibleAnywhere)
 	EWeaponType ActiveWeapon;
@@ -61,6 +61,7 @@ public:
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	void StartWithKindofWeapon();
 	void PurchaseWeapon(EWeaponType WeaponType);
@@ -73,14 +74,21 @@ public:
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
-	UFUNCTION(NetMulticast, Reliable, WithValidation)
-	void MultiShooting();
-	void MultiShooting_Implementation();
-	bool MultiShooting_Validate();
+	virtual bool CallRemoteFunction(UFunction* Function, void* Parameters,
+		FOutParmRec* OutParms, FFrame* Stack) override;
 
-	UFUNCTION(NetMulticast, Reliable, WithValidation)
-	void MultiDead();
-	void MultiDead_Implementation();
-	bool MultiDead_Validate();
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
+	void GetLifetimeReplicatedProps(
+		TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Bumped for every death animation, a grenade can knock the AI down without killing it
+	UPROPERTY(ReplicatedUsing = OnRep_DeadCounter)
+	uint8 DeadCounter;
+
+	UFUNCTION()
+	void OnRep_DeadCounter();
+
+	void PlayDead();
 
 };
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+/**
+ * Counts the calls into GMalloc made while in scope, from the game thread and from every other thread,
+ * so work a scope hands to the task graph is counted too. Other threads that happen to allocate at the
+ * same time are counted as well, keep the engine idle around a scope. The counting allocator only
+ * exists when the game runs with -homeworkalloccount: it wraps GMalloc at pre-main init, before any
+ * other thread allocates, the way -mallocproxy does, and is never swapped at runtime. That needs
+ * the module loaded by then (monolithic builds), otherwise scopes count nothing.
+ */
+struct HOMEWORK_API FScopedAllocationCounter
+{
+	FScopedAllocationCounter();
+	~FScopedAllocationCounter();
+
+	static bool IsInstalled();
+
+	// Mallocs and growing reallocs since the scope opened
+	int32 GetAllocations() const;
+	int64 GetBytes() const;
+
+private:
+	int32 StartAllocations;
+	int64 StartBytes;
+};
+
+/** Stops counting on every thread while in scope, for engine work a test does not own (spawns, RPCs) */
+struct HOMEWORK_API FScopedAllocationCounterPause
+{
+	FScopedAllocationCounterPause();
+	~FScopedAllocationCounterPause();
+
+private:
+	int32 PausedScopes;
+};
+
+#define ALLOCATION_COUNTER_PAUSE() FScopedAllocationCounterPause PREPROCESSOR_JOIN(AllocationCounterPause_, __LINE__)
+#else
+#define ALLOCATION_COUNTER_PAUSE()
+#endif
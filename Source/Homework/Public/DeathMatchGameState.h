@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameStateBase.h"
+#include "Engine/NetSerialization.h"
+#include "DeathMatchScoreboard.h"
+#include "DeathMatchGameState.generated.h"
+
+class ADeathMatchGameState;
+
+// Sent once per player
+USTRUCT()
+struct FDeathMatchNameItem : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint16 PlayerId = 0;
+
+	UPROPERTY()
+	FName PlayerName;
+
+	void PostReplicatedAdd(const struct FDeathMatchNameArray& InArraySerializer);
+};
+
+USTRUCT()
+struct FDeathMatchNameArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FDeathMatchNameItem> Items;
+
+	UPROPERTY(NotReplicated)
+	ADeathMatchGameState* Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FDeathMatchNameItem, FDeathMatchNameArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FDeathMatchNameArray> : public TStructOpsTypeTraitsBase2<FDeathMatchNameArray>
+{
+	enum { WithNetDeltaSerializer = true };
+};
+
+// Only the rows whose score changed are sent
+USTRUCT()
+struct FDeathMatchScoreItem : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint16 PlayerId = 0;
+
+	UPROPERTY()
+	int32 PlayerScore = 0;
+
+	void PostReplicatedAdd(const struct FDeathMatchScoreArray& InArraySerializer);
+	void PostReplicatedChange(const struct FDeathMatchScoreArray& InArraySerializer);
+	void PreReplicatedRemove(const struct FDeathMatchScoreArray& InArraySerializer);
+};
+
+USTRUCT()
+struct FDeathMatchScoreArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FDeathMatchScoreItem> Items;
+
+	UPROPERTY(NotReplicated)
+	ADeathMatchGameState* Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FDeathMatchScoreItem, FDeathMatchScoreArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FDeathMatchScoreArray> : public TStructOpsTypeTraitsBase2<FDeathMatchScoreArray>
+{
+	enum { WithNetDeltaSerializer = true };
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnDeathMatchScoreboardChanged);
+
+/**
+ * Authoritative death match scoreboard. Players are keyed by a compact id, the server assigns it
+ * the first time a name scores and the name itself is replicated only once.
+ */
+UCLASS()
+class HOMEWORK_API ADeathMatchGameState : public AGameStateBase
+{
+	GENERATED_BODY()
+
+public:
+	ADeathMatchGameState();
+
+	// Server only, returns the id of the player behind the actor (registers it if needed). Players are
+	// registered from PostLogin and keep their row by name, AI from OnPossess with a row per AI
+	uint16 RegisterPlayer(AActor* Player);
+	// Server only, the id of a registered player, never adds a row
+	bool FindPlayerId(const AActor* Player, uint16& OutId) const;
+	void AddScore(AActor* Player, int32 Delta);
+	// Server only, drops the row of an AI that is going away
+	void RemovePlayer(AActor* Player);
+
+	// Ranked view, kept up to date on the server and on every client
+	const FDeathMatchScoreboard& GetScoreboard() const { return Scoreboard; }
+
+	UFUNCTION(BlueprintPure, Category = "Scoreboard")
+	int32 GetPlayerRank(FName PlayerName) const { return Scoreboard.GetRank(PlayerName); }
+
+	UFUNCTION(BlueprintPure, Category = "Scoreboard")
+	bool GetEntryAtRank(int32 Rank, FDeathMatchPlayerData& OutData) const;
+
+	UFUNCTION(BlueprintPure, Category = "Scoreboard")
+	int32 GetNumPlayers() const { return Scoreboard.Num(); }
+
+	UPROPERTY(BlueprintAssignable, Category = "Scoreboard")
+	FOnDeathMatchScoreboardChanged OnScoreboardChanged;
+
+	void GetLifetimeReplicatedProps(
+		TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Replication callbacks
+	void OnNameReplicated(const FDeathMatchNameItem& Item);
+	void OnScoreReplicated(const FDeathMatchScoreItem& Item);
+	void OnScoreRemoved(const FDeathMatchScoreItem& Item);
+
+private:
+	UPROPERTY(Replicated)
+	FDeathMatchNameArray PlayerNames;
+
+	UPROPERTY(Replicated)
+	FDeathMatchScoreArray PlayerScores;
+
+	FDeathMatchScoreboard Scoreboard;
+
+	TMap<FName, uint16> IdByName;
+	TMap<uint16, FName> NameById;
+	TMap<uint16, int32> ScoreIndexById;
+	// AI have no player state, their row follows the pawn that registered it
+	TMap<TWeakObjectPtr<const AActor>, uint16> IdByActor;
+
+	uint16 NextPlayerId;
+};
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "KisMetMultiFPSLibrary.h"
+#include "DeathMatchScoreboard.generated.h"
+
+/**
+ * Scoreboard kept in rank order (highest score first). A score change moves a single entry
+ * with a binary search instead of re-sorting the whole board.
+ */
+USTRUCT(BlueprintType)
+struct HOMEWORK_API FDeathMatchScoreboard
+{
+	GENERATED_BODY()
+
+	// Adds the player with score 0 if missing, returns the new rank
+	int32 AddPlayer(FName PlayerName);
+	bool RemovePlayer(FName PlayerName);
+
+	// Returns the new rank of the player, adds the player if missing
+	int32 AddScore(FName PlayerName, int32 Delta);
+	int32 SetScore(FName PlayerName, int32 Score);
+
+	// 0 based rank, INDEX_NONE if the player is not on the board
+	int32 GetRank(FName PlayerName) const;
+	const FDeathMatchPlayerData* Find(FName PlayerName) const;
+
+	TArrayView<const FDeathMatchPlayerData> GetTopK(int32 K) const
+	{
+		return TArrayView<const FDeathMatchPlayerData>(Ranked.GetData(), FMath::Clamp(K, 0, Ranked.Num()));
+	}
+	const TArray<FDeathMatchPlayerData>& GetRanked() const { return Ranked; }
+	int32 Num() const { return Ranked.Num(); }
+
+	void Reset();
+
+	void PostSerialize(const FArchive& Ar) { RebuildIndex(); }
+
+private:
+	int32 MoveToRank(int32 Index, int32 NewScore);
+	void ReindexRange(int32 First, int32 Last);
+	// The index is not a property, copies made by serialization (replication, Blueprint) arrive without it
+	void EnsureIndex() const;
+	void RebuildIndex() const;
+
+	UPROPERTY()
+	TArray<FDeathMatchPlayerData> Ranked;
+
+	mutable TMap<FName, int32> RankByName;
+};
+
+template<>
+struct TStructOpsTypeTraits<FDeathMatchScoreboard> : public TStructOpsTypeTraitsBase2<FDeathMatchScoreboard>
+{
+	enum { WithPostSerialize = true };
+};
+
+UCLASS()
+class HOMEWORK_API UDeathMatchScoreboardLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, Category = "Scoreboard")
+	static int32 AddPlayerScore(UPARAM(ref)FDeathMatchScoreboard& Board, FName PlayerName, int32 Delta);
+
+	UFUNCTION(BlueprintCallable, Category = "Scoreboard")
+	static bool RemovePlayer(UPARAM(ref)FDeathMatchScoreboard& Board, FName PlayerName);
+
+	UFUNCTION(BlueprintPure, Category = "Scoreboard")
+	static int32 GetPlayerRank(const FDeathMatchScoreboard& Board, FName PlayerName);
+
+	UFUNCTION(BlueprintPure, Category = "Scoreboard")
+	static bool GetEntryAtRank(const FDeathMatchScoreboard& Board, int32 Rank, FDeathMatchPlayerData& OutData);
+
+	UFUNCTION(BlueprintPure, Category = "Scoreboard")
+	static int32 GetNumPlayers(const FDeathMatchScoreboard& Board);
+
+	// Blueprint arrays are copies, prefer GetEntryAtRank for single rows
+	UFUNCTION(BlueprintPure, Category = "Scoreboard")
+	static void GetTopPlayers(const FDeathMatchScoreboard& Board, int32 K, TArray<FDeathMatchPlayerData>& OutTop);
+};
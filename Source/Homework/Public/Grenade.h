@@ -4,10 +4,10 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "GrenadeTrajectory.h"
 #include "Grenade.generated.h"
 
 class USphereComponent;
-class UProjectileMovementComponent;
 class AHomeworkCharacter;
 
 UCLASS(config = Game)
@@ -18,9 +18,6 @@ class HOMEWORK_API AGrenade : public AActor
 	UPROPERTY(VisibleDefaultsOnly, Category=Projectile)
 	USphereComponent* CollisionComp;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Movement, meta = (AllowPrivateAccess = "true"))
-	UProjectileMovementComponent* ProjectileMovement;
-
 public:	
 	AGrenade();
 
@@ -34,6 +31,13 @@ public:
 
 	float Impulse;
 
+	UPROPERTY(EditAnywhere, Category = Projectile)
+	float LaunchSpeed;
+
+	// Seconds from the throw to the explosion
+	UPROPERTY(EditAnywhere, Category = Projectile)
+	float FuseTime;
+
 	AHomeworkCharacter* GrenadeOwner;
 
 	UPROPERTY(EditAnywhere)
@@ -44,6 +48,12 @@ public:
 	
 	void PlayExplosion(AHomeworkCharacter* HomeWorkCharactor);
 
+	// Solves the whole flight locally, the same on every machine for the same arguments
+	void Launch(AHomeworkCharacter* InOwner, const FVector& Location, const FRotator& Rotation, int32 Seed);
+
+	// Server deflection off something the static solve can't see (pawns)
+	void ApplyCorrection(const FVector& Location, const FVector& Velocity, float Time);
+
 
 protected:
 	virtual void BeginPlay() override;
@@ -52,6 +62,16 @@ public:
 	virtual void Tick(float DeltaTime) override;
 
 	USphereComponent* GetCollisionComp() const { return CollisionComp; }
-	UProjectileMovementComponent* GetProjectileMovement() const { return ProjectileMovement; }
 
+private:
+	// Server only, true if a pawn is in the way and a correction was sent
+	bool CheckPawnDeflection(const FVector& From, const FVector& To);
+	// Server only, calls OnHit for the physics body swept into this frame
+	void CheckPropHit(const FVector& From, const FVector& To);
+
+	FGrenadeTrajectory Trajectory;
+	float FlightTime;
+	int32 TrajectorySeed;
+	TWeakObjectPtr<AActor> LastDeflector;
+	TWeakObjectPtr<UPrimitiveComponent> LastPushed;
 };
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class UWorld;
+
+/**
+ * Fixed step grenade path. Every machine solves it from the same quantized launch data and seed
+ * against static geometry only, so all of them get the same bounces and the same end point.
+ */
+struct HOMEWORK_API FGrenadeTrajectory
+{
+	static constexpr float StepTime = 1.0f / 60.0f;
+
+	float Bounciness = 0.6f;
+	float Friction = 0.2f;
+	// Max random deflection of a bounce, in degrees
+	float BounceSpread = 4.0f;
+	float Radius = 5.0f;
+
+	// Solves from StartTime up to EndTime, replacing whatever was solved before
+	void Solve(const UWorld* World, const FVector& Location, const FVector& Velocity, int32 Seed,
+		float InStartTime, float EndTime, const AActor* IgnoreActor);
+
+	FVector Sample(float Time) const;
+	FVector SampleVelocity(float Time) const;
+	float GetStartTime() const { return StartTime; }
+	bool IsSolved() const { return Points.Num() > 0; }
+
+	// Rounds launch data the way the network will, so the server solves what clients receive
+	static FVector QuantizeLocation(const FVector& Location);
+	static FVector QuantizeVelocity(const FVector& Velocity);
+	static FRotator QuantizeRotation(const FRotator& Rotation);
+
+private:
+	float StartTime = 0.0f;
+	TArray<FVector> Points;
+	TArray<FVector> Velocities;
+};
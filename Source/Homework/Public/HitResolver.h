@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Hitbox.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Engine/NetSerialization.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "HitResolver.generated.h"
+
+class AHomeworkCharacter;
+
+/**
+ * Server side, collects the shots the fire RPCs received and resolves them once at the end of the
+ * tick. Characters are posed once for the whole batch, the shots are traced on worker threads and
+ * every ray writes its own slot, so the result does not depend on scheduling. The game thread and
+ * one task per worker take shots off a shared counter; the tasks come from the task graph's
+ * recycled small task pool, so a warmed up batch does not touch the heap. Damage and decals are
+ * applied on the game thread in the order the shots came in. Homework.Hits.Parallel 0 resolves every
+ * shot on arrival as before.
+ */
+UCLASS()
+class HOMEWORK_API UHitResolver : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	// Rays of one shot from the shooter's current weapon, within ServerFire so the shot trace id is kept
+	static void Submit(AHomeworkCharacter* Shooter, const FVector& Start, TArrayView<const FVector> Ends,
+		const FVector& Forward);
+
+	void Queue(AHomeworkCharacter* Shooter, const FVector& Start, TArrayView<const FVector> Ends,
+		const FVector& Forward, float BaseDamage, uint32 ShotId);
+	// Resolves and applies everything queued
+	void Flush();
+
+#if !UE_BUILD_SHIPPING
+	// Homework.Hits.Bench, serial against parallel resolution of the same random batch
+	void Bench(int32 NumShots, FOutputDevice& Ar);
+#endif
+
+private:
+	struct FQueuedShot
+	{
+		TWeakObjectPtr<AHomeworkCharacter> Shooter;
+		FVector Start;
+		FVector Forward;
+		float BaseDamage;
+		uint32 ShotId;
+		int32 FirstRay;
+		int32 NumRays;
+	};
+
+	friend class FHitResolveTask;
+
+	void Resolve(bool bParallel);
+	// Takes queued shots until there are none left, on the game thread and the resolve tasks
+	void ResolveShots();
+	void ResolveShot(const FQueuedShot& Shot);
+	void Apply();
+	void OnActorSpawned(AActor* Actor);
+
+	TArray<FQueuedShot> Shots;
+	// One slot per ray, across all queued shots
+	TArray<FVector> RayStarts;
+	TArray<FVector> RayEnds;
+	TArray<int32> RayIgnoreOwners;
+	TArray<FHitResult> RayHits;
+	TArray<float> RayDamages;
+	// Per frame scratch for the decals of the shot being applied, kept across frames for its capacity
+	TArray<FVector_NetQuantize> DecalLocations;
+	TArray<FVector_NetQuantizeNormal> DecalNormals;
+
+	// Every character of the world, kept from spawns instead of searching the world per batch
+	TArray<TWeakObjectPtr<ACharacter>> Targets;
+	FDelegateHandle ActorSpawnedHandle;
+
+	TArray<ACharacter*> Candidates;
+	TArray<ACharacter*> Characters;
+	FHitboxCapsules Capsules;
+
+	// State of the batch being resolved, shared with the resolve tasks
+	const FCollisionQueryParams* BatchParams = nullptr;
+	TAtomic<int32> NextShot{ 0 };
+	FGraphEventArray ResolveTasks;
+};
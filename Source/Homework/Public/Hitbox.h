@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ACharacter;
+class UPhysicalMaterial;
+class UWorld;
+struct FCollisionQueryParams;
+struct FHitResult;
+
+// Same zones as the physical material surface types DamagePlayer switches on
+enum class EHitZone : uint8
+{
+	None,
+	Head,	// SurfaceType1
+	Body,	// SurfaceType2
+	Arm,	// SurfaceType3
+	Leg		// SurfaceType4
+};
+
+/**
+ * Hitbox capsules stored struct of arrays, padded to a multiple of 4 so the ray kernel can
+ * test four capsules per iteration without a scalar tail.
+ */
+struct HOMEWORK_API FHitboxCapsules
+{
+	void Reset();
+	void Add(const FVector& A, const FVector& B, float Radius, int32 Owner, FName Bone,
+		const TWeakObjectPtr<UPhysicalMaterial>& PhysMaterial);
+	int32 Num() const { return Count; }
+
+	// Closest capsule entered by the segment, INDEX_NONE if none. OutTime is the fraction along the segment.
+	// Capsules of IgnoreOwner are skipped
+	int32 Intersect(const FVector& Start, const FVector& End, float& OutTime, int32 IgnoreOwner = INDEX_NONE) const;
+	// Reference version of the same math, one capsule at a time
+	int32 IntersectScalar(const FVector& Start, const FVector& End, float& OutTime, int32 IgnoreOwner = INDEX_NONE) const;
+
+	TArray<float> AX, AY, AZ;
+	TArray<float> BX, BY, BZ;
+	TArray<float> RadiusSq;
+	TArray<int32> Owners;
+	TArray<FName> Bones;
+	TArray<TWeakObjectPtr<UPhysicalMaterial>> PhysMaterials;
+
+private:
+	int32 Count = 0;
+};
+
+/**
+ * Server hit registration against hitbox capsules built from the characters' physics assets.
+ * Walls and props still go through a regular trace, characters are skipped by it. Callers pass
+ * the characters that can be hit, the queries never search the world for them.
+ */
+struct HOMEWORK_API FHitboxQuery
+{
+	// Fills OutHit like a Visibility trace with bReturnPhysicalMaterial would
+	static bool LineTrace(UWorld* World, TArrayView<ACharacter* const> Candidates, const FVector& Start, const FVector& End,
+		const AActor* IgnoreActor, FHitResult& OutHit);
+
+	static EHitZone GetZone(const UPhysicalMaterial* PhysMaterial);
+	static float GetDamageMultiplier(EHitZone Zone);
+
+	// Rays sharing a start (pellets), characters are gathered and posed once for all of them.
+	// OutHits[i].bBlockingHit tells whether ray i hit anything
+	static void LineTraceBatch(UWorld* World, TArrayView<ACharacter* const> Candidates, const FVector& Start,
+		TArrayView<const FVector> Ends, const AActor* IgnoreActor, TArray<FHitResult>& OutHits);
+
+	// Candidates whose bounds come within reach of any of the segments, and their capsules
+	static void Gather(TArrayView<ACharacter* const> Candidates, const FVector& Start, TArrayView<const FVector> Ends,
+		const AActor* IgnoreActor, TArray<ACharacter*>& OutCharacters, FHitboxCapsules& OutCapsules);
+	// Same for segments with their own starts
+	static void Gather(TArrayView<ACharacter* const> Candidates, TArrayView<const FVector> Starts,
+		TArrayView<const FVector> Ends, TArray<ACharacter*>& OutCharacters, FHitboxCapsules& OutCapsules);
+
+	// One ray against gathered capsules and the physics scene. Params must ignore the characters.
+	// Reads only, safe on worker threads once the capsules are gathered
+	static void ResolveRay(const UWorld* World, const FVector& Start, const FVector& End, const FCollisionQueryParams& Params,
+		TArrayView<ACharacter* const> Characters, const FHitboxCapsules& Capsules, int32 IgnoreOwner, FHitResult& OutHit);
+};
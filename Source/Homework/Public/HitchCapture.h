@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UObject;
+class UWorld;
+
+// One game thread frame of gameplay scopes and events, fixed size so recording never allocates
+struct FHitchFrame
+{
+	static constexpr int32 MaxScopes = 48;
+	static constexpr int32 MaxEvents = 8;
+
+	struct FScope
+	{
+		const TCHAR* Name;
+		float Ms;
+		int32 Depth;
+	};
+
+	struct FEvent
+	{
+		const TCHAR* Type;
+		FName Subject;
+		float Ms;	// Since the frame started
+	};
+
+	uint64 FrameNumber = 0;
+	float FrameMs = 0.0f;
+	int32 NumScopes = 0;
+	int32 NumEvents = 0;
+	int32 NumDropped = 0;
+	FScope Scopes[MaxScopes];
+	FEvent Events[MaxEvents];
+};
+
+/**
+ * Keeps the last Homework.Hitch.Frames frames of gameplay scope timings. A frame longer than
+ * Homework.Hitch.BudgetMs writes them, with the explosions, spawns, deaths and weapon loads seen,
+ * to Saved/Profiling/Hitches
+ */
+class HOMEWORK_API FHitchCapture
+{
+public:
+	static FHitchCapture& Get();
+
+	void Initialize();
+	void Shutdown();
+
+	int32 BeginScope(const TCHAR* Name);
+	void EndScope(int32 Slot, double StartTime);
+	void AddEvent(const TCHAR* Type, const UObject* Subject);
+
+	// Writes the buffer now, returns the file
+	FString Dump(const TCHAR* Reason);
+
+private:
+	void OnEndFrame();
+	void OnPostLoadMap(UWorld* World);
+	void Reset();
+	FHitchFrame& GetFrame() { return Frames[Current]; }
+
+	TArray<FHitchFrame> Frames;
+	int32 Current = 0;
+	int32 Depth = 0;
+	bool bEnabled = false;
+	double FrameStartTime = 0.0;
+	double LastDumpTime = 0.0;
+	FString MapName;
+};
+
+// Times the enclosing block into the hitch buffer, game thread only
+struct HOMEWORK_API FHitchScope
+{
+	explicit FHitchScope(const TCHAR* Name);
+	~FHitchScope();
+
+private:
+	int32 Slot;
+	double StartTime;
+};
+
+#define HITCH_SCOPE(Name) FHitchScope PREPROCESSOR_JOIN(HitchScope_, __LINE__)(TEXT(Name))
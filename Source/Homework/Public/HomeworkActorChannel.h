@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/ActorChannel.h"
+#include "NetStatsCollector.h"
+#include "UObject/CoreNet.h"
+#include "HomeworkActorChannel.generated.h"
+
+/**
+ * Actor channel of the game net driver (ChannelDefinitions in DefaultEngine.ini), reports the
+ * bunches it sends to FNetStatsCollector
+ */
+UCLASS(transient, customConstructor)
+class HOMEWORK_API UHomeworkActorChannel : public UActorChannel
+{
+	GENERATED_BODY()
+
+public:
+	UHomeworkActorChannel(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+	virtual FPacketIdRange SendBunch(FOutBunch* Bunch, bool Merge) override;
+
+private:
+	FNetStatsPropertyShadows PropertyShadows;
+};
+
+/**
+ * Stands in for the connection's package map when NetStats sizes a property: an object reference
+ * is written as a packed NetGUID, nothing is assigned or exported
+ */
+UCLASS(transient)
+class HOMEWORK_API UNetStatsPackageMap : public UPackageMap
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool SerializeObject(FArchive& Ar, UClass* InClass, UObject*& Obj, FNetworkGUID* OutNetGUID = nullptr) override;
+};
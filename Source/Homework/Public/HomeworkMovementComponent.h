@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "HomeworkMovementComponent.generated.h"
+
+UENUM(BlueprintType)
+enum class ESpeedMode : uint8
+{
+	Normal,
+	LowSpeedWalk,
+	HighSpeedRun
+};
+
+/**
+ * Server poses of a simulated proxy in server time. Sampled a fixed delay behind the newest one,
+ * so there is usually a pose on both sides of the render time even at low update rates.
+ */
+struct HOMEWORK_API FMovementSnapshotBuffer
+{
+	struct FSnapshot
+	{
+		double Time;
+		FVector Location;
+		FQuat Rotation;
+		FVector Velocity;
+	};
+
+	void Add(double Time, const FVector& Location, const FQuat& Rotation, const FVector& Velocity);
+	void Reset() { Snapshots.Reset(); }
+	bool IsEmpty() const { return Snapshots.Num() == 0; }
+
+	// Past the newest pose extrapolates along its velocity for at most MaxExtrapolation seconds.
+	// Returns false once that runs out and the pose is held
+	bool Sample(double Time, float MaxExtrapolation, FVector& OutLocation, FQuat& OutRotation) const;
+
+	TArray<FSnapshot, TInlineAllocator<32>> Snapshots;
+};
+
+/**
+ * Character movement with walk and sprint carried in the saved move flags, so the server
+ * simulates every move with the same speed the client predicted it with.
+ * Simulated proxies render from a snapshot buffer InterpolationDelay behind the server.
+ */
+UCLASS()
+class HOMEWORK_API UHomeworkMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	UHomeworkMovementComponent();
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Walking")
+	float LowSpeedWalkSpeed;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Walking")
+	float HighSpeedRunSpeed;
+
+	// One update interval at 10 Hz plus jitter, a lost update is covered by extrapolation
+	UPROPERTY(EditAnywhere, Category = "Character Movement (Networking)")
+	float InterpolationDelay;
+
+	UPROPERTY(EditAnywhere, Category = "Character Movement (Networking)")
+	float MaxExtrapolationTime;
+
+	// Local input, picked up by the next saved move
+	void SetSpeedMode(ESpeedMode Mode);
+
+	UFUNCTION(BlueprintPure, Category = "Character Movement: Walking")
+	ESpeedMode GetSpeedMode() const;
+
+	virtual float GetMaxSpeed() const override;
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+	virtual bool ClientUpdatePositionAfterServerUpdate() override;
+	virtual void OnClientCorrectionReceived(FNetworkPredictionData_Client_Character& ClientData, float TimeStamp,
+		FVector NewLocation, FVector NewVelocity, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase,
+		bool bBaseRelativePosition, uint8 ServerMovementMode) override;
+	virtual void SmoothCorrection(const FVector& OldLocation, const FQuat& OldRotation, const FVector& NewLocation,
+		const FQuat& NewRotation) override;
+
+	uint8 bWantsToLowSpeedWalk : 1;
+	uint8 bWantsToHighSpeedRun : 1;
+
+	// Corrections received by this client since the last Homework.Movement.Corrections
+	int32 NumCorrections;
+
+protected:
+	virtual void SmoothClientPosition(float DeltaSeconds) override;
+
+private:
+	bool UseSnapshotInterpolation() const;
+
+	FMovementSnapshotBuffer SnapshotBuffer;
+	// Local time minus server time, lowest seen so a late packet doesn't push the render time back
+	double ServerClockOffset;
+	bool bHasServerClockOffset;
+};
+
+class FSavedMove_Homework : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	virtual void Clear() override;
+	virtual uint8 GetCompressedFlags() const override;
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel,
+		FNetworkPredictionData_Client_Character& ClientData) override;
+	virtual void PrepMoveFor(ACharacter* C) override;
+
+	uint8 bSavedWantsToLowSpeedWalk : 1;
+	uint8 bSavedWantsToHighSpeedRun : 1;
+};
+
+class FNetworkPredictionData_Client_Homework : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FNetworkPredictionData_Client_Homework(const UCharacterMovementComponent& ClientMovement)
+		: Super(ClientMovement)
+	{
+	}
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
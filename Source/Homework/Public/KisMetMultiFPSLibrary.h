@@ -30,6 +30,7 @@ class HOMEWORK_API UKisMetMultiFPSLibrary : public UBlueprintFunctionLibrary
 {
 	GENERATED_BODY()
 
+public:
 	UFUNCTION(BlueprintCallable, Category = "Sort")
 	static void SortValues(UPARAM(ref)TArray<FDeathMatchPlayerData>& Values);
 	
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/CircularQueue.h"
+#include "HAL/Runnable.h"
+
+class AActor;
+
+enum class EMatchEventType : uint8
+{
+	Fire,
+	Hit,
+	Damage,
+	Death,
+	Grenade,
+	Spawn,
+	Pickup
+};
+
+// Fixed size record, written to disk as is
+struct FMatchEventRecord
+{
+	double Time;		// Seconds since the journal was opened
+	uint32 Instigator;	// AActor::GetUniqueID, 0 for none
+	uint32 Target;
+	float X, Y, Z;
+	float Value;		// Damage, remaining HP, ...
+	uint8 Type;			// EMatchEventType
+	uint8 Extra;		// Weapon type, hit zone, ...
+	uint16 Padding;
+	uint32 Reserved;	// Spells out the tail padding so no uninitialized bytes reach the file
+};
+static_assert(sizeof(FMatchEventRecord) == 40, "FMatchEventRecord is part of the journal file format");
+
+struct FMatchJournalHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	uint32 RecordSize;
+	uint32 Padding;
+	int64 StartTicks;	// FDateTime ticks of the match start
+};
+
+// Unique ids are reused after garbage collection, an id is named again whenever its actor changes
+struct FMatchJournalName
+{
+	uint64 Record;		// Index in the journal of the first record that refers to it
+	uint32 Id;
+	FName Name;
+};
+
+/**
+ * Server side match event journal. The game thread pushes records into a lock free single
+ * producer ring, a background thread streams them to Saved/Journal/*.hwj and the names of the
+ * actors they refer to to the .hwjn table next to it.
+ */
+class HOMEWORK_API FMatchJournal : public FRunnable
+{
+public:
+	static constexpr uint32 Magic = 0x314A5748;	// "HWJ1"
+	static constexpr uint32 Version = 3;
+
+	static FMatchJournal& Get();
+
+	// Game thread only, ignored on clients
+	void Record(EMatchEventType Type, const AActor* Instigator, const AActor* Target,
+		const FVector& Location, float Value = 0.0f, uint8 Extra = 0);
+
+	void Open();
+	void Close();
+	bool IsOpen() const { return Thread != nullptr; }
+
+	// FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+	// Offline decoding, returns false if the file is not a journal. Names are empty without the .hwjn table
+	static bool ReadFile(const FString& Path, FMatchJournalHeader& OutHeader, TArray<FMatchEventRecord>& OutRecords,
+		TArray<FMatchJournalName>& OutNames);
+	static FString GetNamesPath(const FString& JournalPath);
+	static const TCHAR* GetTypeName(uint8 Type);
+
+private:
+	FMatchJournal();
+	void Drain(FArchive& Writer, FArchive& NameWriter);
+	uint32 GetId(const AActor* Actor);
+
+	TCircularQueue<FMatchEventRecord> Queue;
+	TCircularQueue<FMatchJournalName> NameQueue;
+	// Game thread, the name last written for each id
+	TMap<uint32, FName> NamedIds;
+	FRunnableThread* Thread;
+	FEvent* WakeEvent;
+	TAtomic<bool> bStopping;
+	FString Path;
+	double StartTime;
+	// Game thread, records queued since the journal was opened, which is their index in the file
+	uint64 NumRecords;
+	int32 DroppedRecords;
+};
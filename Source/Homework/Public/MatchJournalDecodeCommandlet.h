@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MatchJournalDecodeCommandlet.generated.h"
+
+/**
+ * Decodes a match journal to CSV:
+ * UE4Editor-Cmd Homework.uproject -run=MatchJournalDecode -file=Match.hwj [-out=Match.csv]
+ */
+UCLASS()
+class HOMEWORK_API UMatchJournalDecodeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	virtual int32 Main(const FString& Params) override;
+};
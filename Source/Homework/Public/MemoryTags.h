@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+
+class UWorld;
+
+// Low level memory tracker tags, run with -llm and check stat LLMFULL or the per match CSV
+LLM_DECLARE_TAG_API(Homework, HOMEWORK_API);
+LLM_DECLARE_TAG_API(Homework_Weapons, HOMEWORK_API);
+LLM_DECLARE_TAG_API(Homework_AI, HOMEWORK_API);
+LLM_DECLARE_TAG_API(Homework_Grenades, HOMEWORK_API);
+LLM_DECLARE_TAG_API(Homework_Effects, HOMEWORK_API);
+LLM_DECLARE_TAG_API(Homework_UI, HOMEWORK_API);
+
+/**
+ * Samples the Homework tags while a map is loaded and appends one row per match to
+ * Saved/Profiling/LLM/HomeworkMatches.csv, so headless runs (-llm -nullrhi) can be compared over time
+ */
+class HOMEWORK_API FMemoryTagReport
+{
+public:
+	static FMemoryTagReport& Get();
+
+	void Initialize();
+	void Shutdown();
+	void Report(FOutputDevice& Ar) const;
+
+private:
+	void OnPreLoadMap(const FString& MapName);
+	void OnPostLoadMap(UWorld* World);
+	bool Sample(float DeltaTime);
+	void WriteMatch();
+
+	FDelegateHandle TickerHandle;
+	FString MatchMap;
+	FString MatchNetMode;
+	double MatchStartTime = 0.0;
+	TArray<int64> MatchPeaks;
+};
@@ -6,6 +6,18 @@
 #include "GameFramework/PlayerController.h"
 #include "MultiFPSPlayerController.generated.h"
 
+// HUD state, widgets only hear about the fields that changed, at most once per frame
+struct FPlayerHUDViewModel
+{
+	int32 ClipCurrBullet = INDEX_NONE;
+	int32 GunCurrBullet = 0;
+	int32 CurrHP = INDEX_NONE;
+	float HPPercent = 0.0f;
+	uint32 HPShotId = 0;		// Shot trace of the hit behind the HP change
+	bool bBulletsDirty = false;
+	bool bHPDirty = false;
+};
+
 /**
  * 
  */
@@ -16,6 +28,14 @@ class HOMEWORK_API AMultiFPSPlayerController : public APlayerController
 
 public:
 	void PlayerCameraShake(TSubclassOf<UCameraShakeBase> CameraShake);
+
+	// Marks the HUD fields dirty, UpdateBulletUI / UpdateHPUI are called from PlayerTick
+	void SetBulletView(int32 ClipCurrBullet, int32 GunCurrBullet);
+	void SetHPView(int32 CurrHP, float Percent, uint32 ShotId = 0);
+
+	virtual void PlayerTick(float DeltaTime) override;
+	virtual void ProcessPlayerInput(const float DeltaTime, const bool bGamePaused) override;
+	virtual void AcknowledgePossession(APawn* P) override;
 	
 	UFUNCTION(BlueprintImplementableEvent, Category = "PlyerUI")
 	void CreatPlayerUI();
@@ -31,4 +51,40 @@ public:
 
 	UFUNCTION(BlueprintImplementableEvent, Category = "HP")
 	void DeathMatch(AActor* DamageCauser);
+
+	// Server: the connection gets the spectator feed instead of the characters and weapons,
+	// except its own pawn and Target. Ends with the next possession
+	void StartLowBandwidthSpectating(AActor* Target);
+	void StopLowBandwidthSpectating();
+	bool IsLowBandwidthSpectating() const { return bLowBandwidthSpectator; }
+
+	// Spectate the combatant behind a spectator feed id
+	UFUNCTION(Server, Reliable, WithValidation, BlueprintCallable, Category = "Spectator")
+	void ServerSpectatePlayer(int32 PlayerId);
+	void ServerSpectatePlayer_Implementation(int32 PlayerId);
+	bool ServerSpectatePlayer_Validate(int32 PlayerId);
+
+	// Shot trace clock sync, the client keeps its offset to the server's FPlatformTime
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void ServerShotClockPing(double ClientTime);
+	void ServerShotClockPing_Implementation(double ClientTime);
+	bool ServerShotClockPing_Validate(double ClientTime);
+
+	UFUNCTION(Client, Unreliable)
+	void ClientShotClockPong(double ClientTime, double ServerTime);
+	void ClientShotClockPong_Implementation(double ClientTime, double ServerTime);
+
+	static bool IsLowBandwidthSpectator(const AActor* RealViewer);
+	// Relevancy filter, Actor is a character or the holder of a weapon
+	static bool IsFilteredForSpectator(const AActor* RealViewer, const AActor* Actor);
+
+protected:
+	virtual void OnPossess(APawn* InPawn) override;
+
+private:
+	FPlayerHUDViewModel HUDView;
+
+	bool bLowBandwidthSpectator = false;
+	double LastShotClockPingTime = 0.0;
+	TWeakObjectPtr<AActor> SpectatedTarget;
 };
@@ -7,6 +7,21 @@
 #include "MyUserWidget.generated.h"
 
 class AHomeworkCharacter;
+
+UENUM(BlueprintType)
+enum class ETouchAction : uint8
+{
+	Fire,
+	Jump,
+	PitchGrenade,
+	Reload,
+	HighSpeedRun,
+	SwitchForT,
+	LockDirection,
+	Aim,
+	Count UMETA(Hidden)
+};
+
 /**
  * 
  */
@@ -18,6 +33,12 @@ class HOMEWORK_API UMyUserWidget : public UUserWidget
 public:
 	void SetCurrPawn(AHomeworkCharacter* APlayer);
 
+	UFUNCTION(BlueprintCallable)
+	void ActionPressed(ETouchAction Action);
+	UFUNCTION(BlueprintCallable)
+	void ActionReleased(ETouchAction Action);
+
+	// Name based entry points kept for existing widgets, prefer ActionPressed/ActionReleased
 	UFUNCTION(BlueprintCallable)
 	void ButtonClick(FString Name);
 	UFUNCTION(BlueprintCallable)
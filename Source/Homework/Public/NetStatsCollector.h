@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "UObject/CoreNetTypes.h"
+#include "UObject/WeakObjectPtr.h"
+
+#define WITH_HOMEWORK_NETSTATS !UE_BUILD_SHIPPING
+
+class AActor;
+class UFunction;
+class UNetConnection;
+class FProperty;
+
+enum class ENetStatsKind : uint8
+{
+	RPC,
+	Actor,		// Property replication and channel traffic of an actor class, RPCs excluded
+	Property	// Payload of one replicated property, part of its actor's bytes
+};
+
+struct FNetStatsEntry
+{
+	int64 Bits = 0;
+	int32 Count = 0;
+};
+
+// Last value of every replicated property of an actor as sent on one connection, kept by its channel
+struct FNetStatsPropertyShadows
+{
+	struct FValue
+	{
+		TArray<uint8> Bytes;
+		int64 NumBits = 0;
+	};
+
+	TArray<FValue> Values;
+	bool bInitialized = false;
+};
+
+/**
+ * Bandwidth accounting per RPC, per replicating actor class and per replicated property, per
+ * connection, bucketed per second. Actor bytes are the bunches UHomeworkActorChannel actually sends,
+ * so rep conditions, deltas and dormancy are already accounted for. Property bytes are the changed
+ * values in those bunches, serialized the way the rep layout flattens them; handle and header bits
+ * stay with the actor.
+ * Each finished second is appended to a rolling CSV under Saved/Profiling/NetStats on a worker
+ * thread, "Homework.NetStats.Dump" prints the totals sorted by bytes. Off by default, enable with
+ * Homework.NetStats.Enable 1.
+ */
+class HOMEWORK_API FNetStatsCollector
+{
+public:
+	static FNetStatsCollector& Get();
+
+	void Record(const UNetConnection* Connection, ENetStatsKind Kind, FName Name, int64 Bits);
+
+	// From UHomeworkActorChannel::SendBunch, bunches sent while an RPC is measured are left to the RPC
+	void RecordActorBunch(const UNetConnection* Connection, const AActor* Actor, int64 Bits,
+		FNetStatsPropertyShadows& Shadows);
+
+	void DumpReport(FOutputDevice& Ar);
+	void Reset();
+
+	static bool IsEnabled();
+
+private:
+	struct FKey
+	{
+		int32 Connection;
+		ENetStatsKind Kind;
+		FName Name;
+
+		bool operator==(const FKey& Other) const
+		{
+			return Kind == Other.Kind && Name == Other.Name && Connection == Other.Connection;
+		}
+		friend uint32 GetTypeHash(const FKey& Key)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Key.Connection), GetTypeHash(Key.Name)), uint32(Key.Kind));
+		}
+	};
+
+	// One lifetime replicated property, or one element of a static array
+	struct FRepProperty
+	{
+		FProperty* Property;
+		int32 ArrayIndex;
+		ELifetimeCondition Condition;
+		FName StatName;
+	};
+
+	int32 GetConnectionId(const UNetConnection* Connection);
+	// Resolved when written, not per record
+	const FString& GetConnectionName(int32 Id);
+	const TArray<FRepProperty>& GetRepProperties(UClass* Class);
+	void RecordProperties(const UNetConnection* Connection, const AActor* Actor, FNetStatsPropertyShadows& Shadows);
+	void RollSecond(double Now);
+	void WriteCsv(const TMap<FKey, FNetStatsEntry>& Bucket, int64 Second);
+
+	TMap<FKey, FNetStatsEntry> CurrentSecond;
+	TMap<FKey, FNetStatsEntry> Totals;
+
+	TMap<TWeakObjectPtr<const UNetConnection>, int32> ConnectionIds;
+	TArray<TWeakObjectPtr<const UNetConnection>> Connections;
+	TArray<FString> ConnectionNames;
+	TMap<TWeakObjectPtr<UClass>, TArray<FRepProperty>> RepProperties;
+
+	double SecondStartTime = 0.0;
+	int64 SecondIndex = 0;
+	double CsvStartTime = 0.0;
+	FString CsvPath;
+	// The previous second's append, waited on before the next so lines stay in order
+	TFuture<void> PendingCsvWrite;
+	int32 RPCScopeDepth = 0;
+
+	friend class FNetStatsRPCScope;
+};
+
+/** Measures the bits an RPC writes into every connection's send buffer, use it around Super::CallRemoteFunction. */
+class HOMEWORK_API FNetStatsRPCScope
+{
+public:
+	FNetStatsRPCScope(AActor* Actor, UFunction* Function);
+	~FNetStatsRPCScope();
+
+private:
+	struct FConnectionSnapshot
+	{
+		UNetConnection* Connection;
+		int64 BufferedBits;
+		int64 TotalBytes;
+	};
+
+	TArray<FConnectionSnapshot, TInlineAllocator<16>> Snapshots;
+	FName FunctionName;
+	bool bCounted = false;
+};
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NetUpdateManager.generated.h"
+
+/**
+ * Server side, once a second sets the net update frequency and priority of characters, AI and
+ * weapons from the distance to the nearest viewer, movement, recent combat and server frame time.
+ * Actors in combat never drop below CombatMinFrequency.
+ */
+UCLASS()
+class HOMEWORK_API UNetUpdateManager : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UNetUpdateManager();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	// Fired or got hit, keeps the actor at combat rate for CombatHoldTime
+	static void NotifyCombat(AActor* Actor);
+
+	void Report(FOutputDevice& Ar) const;
+
+	float NearDistance;
+	float FarDistance;
+	float MinFrequency;
+	float MovingMinFrequency;
+	float CombatMinFrequency;
+	float CombatHoldTime;
+	// Non combat rates are scaled down to this fraction when the server misses its tick rate
+	float MinLoadScale;
+
+private:
+	void UpdateActors();
+	void ApplyRate(AActor* Actor, float Frequency, float Priority);
+	void RestoreDefaults();
+	bool IsInCombat(const AActor* Actor, float Now) const;
+
+	FTimerHandle UpdateTimer;
+	TMap<TWeakObjectPtr<AActor>, float> LastCombatTime;
+
+	// Last pass, for Homework.NetUpdate.Stats
+	int32 NumActors = 0;
+	int32 NumCombat = 0;
+	float AverageFrequency = 0.0f;
+	float AverageDefaultFrequency = 0.0f;
+	float LoadScale = 1.0f;
+	bool bApplied = false;
+};
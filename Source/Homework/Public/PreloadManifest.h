@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "UObject/SoftObjectPath.h"
+#include "PreloadManifest.generated.h"
+
+struct FStreamableHandle;
+class UWorld;
+
+/**
+ * Assets the weapons and the grenade touch on first use, written to DefaultGame.ini by
+ * UE4Editor-Cmd Homework.uproject -run=PreloadManifest and committed
+ */
+UCLASS(config = Game, defaultconfig)
+class HOMEWORK_API UPreloadManifest : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	UPreloadManifest();
+
+	// Blueprint folders the commandlet scans
+	UPROPERTY(config)
+	TArray<FString> SourcePaths;
+
+	UPROPERTY(config)
+	TArray<FSoftObjectPath> Assets;
+};
+
+/**
+ * Streams the manifest while a map loads and keeps it resident. Records the time to playable
+ * and the loads that still happen synchronously afterwards.
+ */
+class HOMEWORK_API FPreloadTimeline
+{
+public:
+	static FPreloadTimeline& Get();
+
+	void Initialize();
+	void Shutdown();
+
+	// The local player has a pawn and a HUD
+	void MarkPlayable();
+	bool HasUsed(FName Action) const { return UsedActions.Contains(Action); }
+	void RecordFirstUse(FName Action, double Seconds);
+	void Report(FOutputDevice& Ar) const;
+
+private:
+	void OnPreLoadMap(const FString& MapName);
+	void OnPostLoadMap(UWorld* World);
+	void OnManifestLoaded();
+	void OnSyncLoadPackage(const FString& PackageName);
+	void AddEvent(const FString& Event);
+
+	TSharedPtr<FStreamableHandle> Handle;
+	TArray<TPair<double, FString>> Events;
+	TSet<FName> UsedActions;
+	double MapLoadStartTime = 0.0;
+	double ManifestStartTime = 0.0;
+	bool bPlayable = false;
+};
+
+// Times an action the first time it runs, e.g. the first shot or the first scope in
+struct HOMEWORK_API FPreloadFirstUseScope
+{
+	explicit FPreloadFirstUseScope(FName InAction);
+	~FPreloadFirstUseScope();
+
+private:
+	FName Action;
+	double StartTime;
+};
@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "UObject/SoftObjectPath.h"
+#include "PreloadManifestCommandlet.generated.h"
+
+/**
+ * Regenerates the preload manifest from the weapon and grenade blueprints and their dependencies:
+ * UE4Editor-Cmd Homework.uproject -run=PreloadManifest
+ * The result is committed with the blueprints. Build machines run it with -check before cooking,
+ * which fails on a stale manifest and writes nothing.
+ */
+UCLASS()
+class HOMEWORK_API UPreloadManifestCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	virtual int32 Main(const FString& Params) override;
+
+	// The manifest the blueprints currently need, sorted
+	static TArray<FSoftObjectPath> Collect();
+};
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "PropPhysicsManager.generated.h"
+
+class UPrimitiveComponent;
+
+/**
+ * Server side owner of the simulated props. Bullet and grenade impulses are summed per body and
+ * applied once at the end of the frame. Props replicate their movement with coarse quantization and
+ * go dormant while their body sleeps, so a settled prop sends nothing. Any replicated actor with a
+ * simulating root is a prop, and so is one tagged Prop; pawns and weapons never are. Bodies that
+ * are not props are pushed locally on clients as well, nothing replicates their movement.
+ */
+UCLASS()
+class HOMEWORK_API UPropPhysicsManager : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UPropPhysicsManager();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	// Same as UPrimitiveComponent::AddImpulseAtLocation, ignored on clients for props
+	static void AddImpulseAtLocation(UPrimitiveComponent* Component, const FVector& Impulse, const FVector& Location);
+	// For an actor that stops simulating: woken and given back its own replication settings
+	static void Unregister(AActor* Actor);
+
+	// Actor tag for a prop that is not replicated in the level, the server turns replication on
+	static const FName PropTag;
+	static bool IsProp(const AActor* Actor);
+
+	void Report(FOutputDevice& Ar) const;
+
+	// Rate of a prop while its body is awake
+	float AwakeNetUpdateFrequency;
+
+private:
+	struct FPendingImpulse
+	{
+		FVector Linear = FVector::ZeroVector;
+		FVector Angular = FVector::ZeroVector;
+	};
+
+	// What RegisterProp overrides, restored by Unregister
+	struct FPropDefaults
+	{
+		float NetUpdateFrequency;
+		bool bReplicateMovement;
+		EVectorQuantization LocationQuantizationLevel;
+		EVectorQuantization VelocityQuantizationLevel;
+		ERotatorQuantization RotationQuantizationLevel;
+	};
+
+	void RegisterProp(AActor* Actor);
+	void UnregisterProp(AActor* Actor);
+	UFUNCTION()
+	void OnPropWake(UPrimitiveComponent* WakingComponent, FName BoneName);
+	UFUNCTION()
+	void OnPropSleep(UPrimitiveComponent* SleepingComponent, FName BoneName);
+
+	TMap<TWeakObjectPtr<UPrimitiveComponent>, FPendingImpulse> Pending;
+	TMap<TWeakObjectPtr<AActor>, FPropDefaults> Props;
+
+	// For Homework.Props.Stats
+	int32 NumAwake = 0;
+	int32 NumImpulses = 0;
+	int32 NumApplied = 0;
+};
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class APawn;
+class UObject;
+
+// The steps of a shot from the shooter's input to the victim's HUD
+enum class EShotStage : uint8
+{
+	Input,			// Shooter client, CSFireProcess
+	ServerFire,		// Server, ServerFire*Weapon received
+	ServerTrace,	// Server, hitbox trace done
+	ServerDamage,	// Server, ApplyPointDamage
+	ServerHit,		// Server, the victim's OnHit took the HP
+	Ack,			// Shooter client, ClientAckShot
+	VictimHUD,		// Victim client, HP widget updated
+	Num
+};
+
+struct FShotTraceRecord
+{
+	uint32 ShotId;
+	EShotStage Stage;
+	double Time;	// Estimated server FPlatformTime::Seconds
+};
+
+/**
+ * Shot latency tracing, on with Homework.ShotTrace.Enable on every machine. A shot is identified by
+ * its shooter's PlayerId and shot sequence. Each machine stamps the stages it sees in server time and
+ * appends them to Saved/Profiling/ShotTrace. Homework.ShotTrace.Report (one process, e.g. PIE) or
+ * UE4Editor-Cmd Homework.uproject -run=ShotTraceReport -dir=<collected csv files> pairs them up.
+ */
+class HOMEWORK_API FShotTrace
+{
+public:
+	static FShotTrace& Get();
+	static bool IsEnabled();
+	// 0 when the shooter has no player state yet, such shots are not traced
+	static uint32 MakeShotId(const APawn* Shooter, uint16 ShotSequence);
+
+	// WorldContext tells whether the stamp is taken on a client and needs the clock offset
+	void Record(const UObject* WorldContext, uint32 ShotId, EShotStage Stage);
+	void Record(const UObject* WorldContext, uint32 ShotId, EShotStage Stage, double LocalTime);
+
+	// Server, the shot ServerFire is resolving, for the stages further down the call chain
+	uint32 GetCurrentShot() const { return CurrentShot; }
+
+	// Client, one clock ping round trip. The offset comes from the fastest of the recent ones
+	void AddClockSample(double ClientSendTime, double ServerTime, double ClientReceiveTime);
+
+	void Flush();
+	void Report(FOutputDevice& Ar) const;
+
+	static void Report(TArray<FShotTraceRecord> Records, FOutputDevice& Ar);
+	static bool ReadFile(const FString& Path, TArray<FShotTraceRecord>& OutRecords);
+	static const TCHAR* GetStageName(EShotStage Stage);
+
+private:
+	friend struct FShotTraceScope;
+
+	struct FClockSample
+	{
+		double RoundTrip;
+		double Offset;
+	};
+
+	uint32 CurrentShot = 0;
+	double ClockOffset = 0.0;
+	TArray<FClockSample> ClockSamples;
+	int32 NextClockSample = 0;
+	TArray<FShotTraceRecord> Records;
+	int32 NumFlushed = 0;
+	FString FilePath;
+};
+
+// Server, makes the shot current while ServerFire resolves it
+struct HOMEWORK_API FShotTraceScope
+{
+	explicit FShotTraceScope(uint32 ShotId);
+	~FShotTraceScope();
+
+private:
+	uint32 PreviousShot;
+};
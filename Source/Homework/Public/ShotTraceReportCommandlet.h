@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ShotTraceReportCommandlet.generated.h"
+
+/**
+ * Shot latency percentiles from the shot trace files of the server and the clients, copied into one folder:
+ * UE4Editor-Cmd Homework.uproject -run=ShotTraceReport [-dir=Saved/Profiling/ShotTrace]
+ */
+UCLASS()
+class HOMEWORK_API UShotTraceReportCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	virtual int32 Main(const FString& Params) override;
+};
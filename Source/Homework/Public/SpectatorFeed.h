@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "Engine/NetSerialization.h"
+#include "SpectatorFeed.generated.h"
+
+class AWeaponBaseServer;
+
+// One combatant, rows only go out when they change
+USTRUCT()
+struct FSpectatorFeedItem : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	// Death match id, the name comes with the scoreboard
+	UPROPERTY()
+	uint16 PlayerId = 0;
+
+	// Snapped to a 25 uu grid so standing players stay quiet
+	UPROPERTY()
+	FVector_NetQuantize Location;
+
+	UPROPERTY()
+	uint8 Yaw = 0;
+
+	UPROPERTY()
+	uint8 Pitch = 0;
+
+	UPROPERTY()
+	bool bAlive = true;
+
+	// Combat since the previous update instead of every shot and hit
+	UPROPERTY()
+	uint8 Shots = 0;
+
+	UPROPERTY()
+	uint8 DamageTaken = 0;
+};
+
+USTRUCT()
+struct FSpectatorFeedArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FSpectatorFeedItem> Items;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FSpectatorFeedItem, FSpectatorFeedArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FSpectatorFeedArray> : public TStructOpsTypeTraitsBase2<FSpectatorFeedArray>
+{
+	enum { WithNetDeltaSerializer = true };
+};
+
+/**
+ * What low bandwidth spectators get instead of the characters: coarse positions, view direction
+ * and combat totals at UpdateRate, relevant only to spectator connections.
+ */
+UCLASS()
+class HOMEWORK_API ASpectatorFeed : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	ASpectatorFeed();
+
+	// Server, spawned with the first spectator
+	static ASpectatorFeed* FindOrSpawn(UWorld* World);
+
+	// Server, the character behind a feed id
+	AActor* FindCombatant(uint16 PlayerId) const;
+
+	UFUNCTION(BlueprintPure, Category = "Spectator")
+	int32 GetNumEntries() const { return Entries.Items.Num(); }
+
+	UFUNCTION(BlueprintPure, Category = "Spectator")
+	bool GetEntry(int32 Index, int32& PlayerId, FVector& Location, FRotator& ViewRotation, bool& bAlive) const;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Spectator")
+	float UpdateRate;
+
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
+	void GetLifetimeReplicatedProps(
+		TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	void UpdateEntries();
+
+	UPROPERTY(Replicated)
+	FSpectatorFeedArray Entries;
+
+	struct FCombatant
+	{
+		TWeakObjectPtr<AActor> Actor;
+		TWeakObjectPtr<AWeaponBaseServer> Weapon;
+		uint8 LastShotCounter = 0;
+		float LastHP = 0.0f;
+	};
+	TMap<uint16, FCombatant> Combatants;
+
+	FTimerHandle UpdateTimer;
+};
@@ -13,17 +13,19 @@ UENUM()
 enum class EWeaponType :uint8
 {
 	FPS UMETA(DisplayName = "FPS"),
-	Sniper UMETA(DisplayName = "Sniper")
+	Sniper UMETA(DisplayName = "Sniper"),
+	Shotgun UMETA(DisplayName = "Shotgun")
 };
 
-UCLASS()
+UCLASS(config = Game)
 class HOMEWORK_API AWeaponBaseServer : public AActor
 {
 	GENERATED_BODY()
 	
 public:	
 	AWeaponBaseServer();
-	UPROPERTY(EditAnywhere)
+	// Replicated once, a rifle blueprint standing in for the shotgun is retuned on clients too
+	UPROPERTY(EditAnywhere, ReplicatedUsing = OnRep_KindOfWeapon)
 	EWeaponType KindOfWeapon;
 
 	UPROPERTY(EditAnywhere)
@@ -86,6 +88,29 @@ public:
 	UPROPERTY(EditAnywhere)
 	float Impulse;
 
+	// Shotgun: rays per shot, BaseDamage is per pellet
+	UPROPERTY(EditAnywhere)
+	int32 PelletCount;
+
+	// Shotgun: half angle of the pellet cone, in degrees
+	UPROPERTY(EditAnywhere)
+	float PelletSpreadAngle;
+
+	// Shotgun built from another weapon's blueprint, until it has a blueprint of its own
+	UPROPERTY(config)
+	int32 ShotgunClipBullets;
+
+	// Shotgun built from another weapon's blueprint: BaseDamage scale giving the per pellet damage
+	UPROPERTY(config)
+	float ShotgunPelletDamageScale;
+
+	// Turns this weapon into a semi automatic shotgun with the config above. Server before
+	// equipping, clients from OnRep_KindOfWeapon
+	void ConfigureAsShotgun();
+
+	UFUNCTION()
+	void OnRep_KindOfWeapon();
+
 	UFUNCTION()
 		void OnOtherBeginOverlap(class UPrimitiveComponent* HitComp, class AActor* OtherActor,
 			class UPrimitiveComponent* OtherComp, int OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
@@ -97,15 +122,33 @@ public:
 	void GetLifetimeReplicatedProps(
 		TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
-	UFUNCTION(NetMulticast, Reliable, WithValidation)
-	void MultiShootingEffect();
-	void MultiShootingEffect_Implementation();
-	bool MultiShootingEffect_Validate();
+	virtual bool CallRemoteFunction(UFunction* Function, void* Parameters,
+		FOutParmRec* OutParms, FFrame* Stack) override;
+
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
+	// Server: plays the holder's shot or reload on every machine. Replicated as burst counters,
+	// a client that missed several shots plays the effect once
+	void NotifyShot();
+	void NotifyReload();
+
+	UPROPERTY(ReplicatedUsing = OnRep_ShotCounter)
+	uint8 ShotCounter;
+
+	UPROPERTY(ReplicatedUsing = OnRep_ReloadCounter)
+	uint8 ReloadCounter;
+
+	UFUNCTION()
+	void OnRep_ShotCounter();
+
+	UFUNCTION()
+	void OnRep_ReloadCounter();
+
+	void PlayShootingEffect();
+	void PlayReloadEffect();
 
-	UFUNCTION(NetMulticast, Reliable, WithValidation)
-	void MultiReloadEffect();
-	void MultiReloadEffect_Implementation();
-	bool MultiReloadEffect_Validate();
+	// The holder hears and sees its own client weapon instead
+	bool IsHeldByLocalPlayer() const;
 
 protected:
 	virtual void BeginPlay() override;
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WeaponMaterialTable.generated.h"
+
+class UMaterialInstanceDynamic;
+class UMaterialInterface;
+
+/**
+ * Weapon material variants (AI, teams) loaded when the world starts. Each variant is one dynamic
+ * instance shared by every weapon using it, equipping never looks an object up.
+ */
+UCLASS(config = Game, defaultconfig)
+class HOMEWORK_API UWeaponMaterialTable : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UWeaponMaterialTable();
+
+	static const FName AIVariant;
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	// Null for an unknown variant or one that failed to load. A variant that missed the preload is
+	// loaded here and counted
+	UMaterialInstanceDynamic* GetMaterial(FName Variant);
+
+	int32 NumEquips = 0;
+	int32 NumLoads = 0;
+
+private:
+	UPROPERTY(config)
+	TMap<FName, TSoftObjectPtr<UMaterialInterface>> Variants;
+
+	UPROPERTY(Transient)
+	TMap<FName, UMaterialInstanceDynamic*> Materials;
+
+	UMaterialInstanceDynamic* LoadVariant(FName Variant);
+};